@@ -0,0 +1,165 @@
+#ifndef VF_BLOCKS_HPP
+#define VF_BLOCKS_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include "window.hpp"
+#include "thread_pool.hpp"
+
+/********* Decomposition into independent blocks of variant positions ******/
+
+/*
+ * A cut between variant positions i-1 and i exists if no window contains
+ * both, e.g., if they are at least alpha apart and no deletion edge spans the
+ * gap. Constraints of different blocks share no variable, so every block can
+ * be solved on its own and the results concatenated.
+ */
+
+/**
+ * @brief   split variant positions 0..n-1 at every cut not crossed by a
+ *          window of w (maximal windows, see constraintWindows), and merge
+ *          consecutive blocks until they hold at least min_size positions
+ */
+void independentBlocks (Windows &blocks, const Windows &w, int n, int min_size = 1)
+{
+  blocks.beg.clear(); blocks.end.clear();
+  int b = 0, e = -1;   //current block begins at b, its windows end by e
+  std::size_t k = 0;
+  for (int i = 0; i < n; i++)
+  {
+    for (; k < w.size() && w.beg[k] <= i; k++) e = std::max(e, w.end[k]);
+    if (e > i || (i+1 - b < min_size && i+1 < n)) continue;
+    blocks.beg.push_back(b); blocks.end.push_back(i);
+    b = i+1;
+  }
+}
+
+/**
+ * @brief   windows of w within block [beg, end], shifted to start at index 0
+ */
+void sliceWindows (Windows &out, const Windows &w, int beg, int end)
+{
+  out.beg.clear(); out.end.clear();
+  std::size_t k = std::lower_bound (w.beg.begin(), w.beg.end(), beg) - w.beg.begin();
+  for (; k < w.size() && w.end[k] <= end; k++)
+  {
+    assert (w.beg[k] >= beg);
+    out.beg.push_back(w.beg[k] - beg); out.end.push_back(w.end[k] - beg);
+  }
+}
+
+/**
+ * @brief   run select(beg, end, R_block) for every block on a pool of worker
+ *          threads, R_block[i-beg] = true retains variant position i, and
+ *          concatenate the results into R. Larger blocks are started first.
+ */
+template <typename Select>
+void selectBlocks (std::vector<bool> &R, const Windows &blocks, int threads, Select select)
+{
+  std::vector<std::vector<bool>> results (blocks.size());
+  std::vector<std::size_t> order (blocks.size());
+  for (std::size_t k = 0; k < blocks.size(); k++) order[k] = k;
+  std::stable_sort (order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return blocks.end[a] - blocks.beg[a] > blocks.end[b] - blocks.beg[b]; });
+
+  auto run = [&](std::size_t k)
+  {
+    results[k].assign (blocks.end[k] - blocks.beg[k] + 1, false);
+    select (blocks.beg[k], blocks.end[k], results[k]);
+  };
+
+  if (threads <= 1)
+    for (auto k: order) run (k);
+  else
+  {
+    ThreadPool pool (std::min<int>(threads, blocks.size()));
+    for (auto k: order) pool.submit([&, k]{ run (k); });
+    pool.wait();
+  }
+
+  for (std::size_t k = 0; k < blocks.size(); k++)
+    std::copy (results[k].begin(), results[k].end(), R.begin() + blocks.beg[k]);
+}
+
+/**
+ * @brief   print count and size of blocks
+ */
+void printBlocks (const Windows &blocks)
+{
+  int largest = 0;
+  for (std::size_t k = 0; k < blocks.size(); k++) largest = std::max(largest, blocks.end[k] - blocks.beg[k] + 1);
+  std::cout << "INFO, VF::printBlocks, " << blocks.size() << " independent blocks, largest has " << largest << " variant positions" << "\n";
+}
+
+/********* Greedy selection over windows ******/
+
+/**
+ * @brief   greedy selection of variant positions to retain, a position is
+ *          dropped if the penalty of all dropped positions within its window
+ *          (reachable using alpha-1 edges, starting at start[i]) stays within
+ *          delta. With right windows, it is checked against the earliest
+ *          beginning window covering it among all windows, see
+ *          constraintWindows, so that every window stays within delta.
+ */
+void greedySelect (std::vector<bool> &R, const std::vector<int> &start, const Windows &right, const std::vector<int> &penalty, const int &delta)
+{
+  std::size_t n = start.size();
+  std::vector<int> cumulative_penalty (n,0); 
+  //cumulative_penalty[i] indicates cumulative penalty until variant position i (exclusive)
+
+  //left windows ending after i may begin before start[i] where reach decreases
+  Windows windows;
+  if (right.size() > 0) constraintWindows (windows, start, right);
+
+  std::size_t r = 0;
+  for (std::size_t i = 0; i < n; i++)
+  {
+    //penalty to drop variant position i
+    int pen = penalty[i];
+
+    //check range
+    int penalty_already_incurred = cumulative_penalty[i] - cumulative_penalty[start[i]];
+
+    //maximal window beginning first among those covering i, if any
+    while (r < windows.size() && windows.end[r] < (int) i) r++;
+    if (r < windows.size() && windows.beg[r] <= (int) i)
+      penalty_already_incurred = std::max(penalty_already_incurred, cumulative_penalty[i] - cumulative_penalty[windows.beg[r]]);
+
+    if (penalty_already_incurred + pen <= delta)
+    {
+      if (i < n-1)
+        cumulative_penalty[i+1] = cumulative_penalty[i] + pen; //drop
+    }
+    else
+    {
+      R[i] = true; //retain
+      if (i < n-1)
+        cumulative_penalty[i+1] = cumulative_penalty[i];
+    }
+  }
+}
+
+/**
+ * @brief   greedySelect on each independent block of windows, see
+ *          independentBlocks, on a pool of threads. Decisions only depend on
+ *          windows covering a position, so the result equals greedySelect.
+ */
+void greedySelectBlocks (std::vector<bool> &R, const std::vector<int> &start, const Windows &right, const std::vector<int> &penalty, const int &delta, int threads, bool verbose = false)
+{
+  Windows windows, blocks;
+  constraintWindows (windows, start, right);
+  independentBlocks (blocks, windows, start.size(), 4096);
+  if (verbose) printBlocks (blocks);
+
+  selectBlocks (R, blocks, threads, [&](int beg, int end, std::vector<bool> &R_block)
+  {
+    std::vector<int> start_block (start.begin() + beg, start.begin() + end + 1), penalty_block (penalty.begin() + beg, penalty.begin() + end + 1);
+    for (auto &s: start_block) s -= beg;
+    Windows right_block;
+    sliceWindows (right_block, right, beg, end);
+    greedySelect (R_block, start_block, right_block, penalty_block, delta);
+  });
+}
+
+#endif
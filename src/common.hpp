@@ -1,4 +1,5 @@
 #include <cassert>
+#include <climits>
 #include "ext/clipp.h"
 
 #define STRINGIFY(x) #x
@@ -12,29 +13,247 @@ struct Parameters
   std::string chr;
   std::string prefix;
   bool pos;
+  bool observed;
+  bool cache;
+  bool piecewise;
+  bool symmetric;
+  bool blocks;
+  bool stream;
+  int threads;
+  std::string region;
+  int region_beg;
+  int region_end;
+  std::string sweep;
+  std::vector<std::pair<int,int>> sweep_points; //(alpha, delta) pairs
+  bool genome_wide;                   //-chr all or a comma separated list
+  std::vector<std::string> chr_list;  //selected chromosomes, empty for all
 };
 
+/**
+ * @brief  optional arguments offered by a tool on top of the common ones
+ */
+enum CLIOption { CLI_STREAM = 1, CLI_AC = 2, CLI_WINDOWS = 4 }; //CLI_WINDOWS: --piecewise, --symmetric and --blocks
+
 inline bool exists (const std::string& filename) {
   std::ifstream f(filename.c_str());
   return f.good();
 }
 
 /**
- * @brief  parse and print command line arguments
+ * @brief  parse optional -region argument of the form chr:start-end,
+ *         chr must match the -chr argument
+ */
+void parseRegion (Parameters &param)
+{
+  param.region_beg = 1; param.region_end = INT_MAX; //default: whole chromosome
+  if (param.region.length() == 0) return;
+
+  std::string r = param.region;
+  r.erase(std::remove(r.begin(), r.end(), ','), r.end()); //allow 1,000,000 style
+  std::size_t colon = r.rfind(':'), dash = r.find('-', colon);
+
+  if (colon == std::string::npos || dash == std::string::npos || r.substr(0, colon) != param.chr)
+  {
+    std::cerr << "ERROR, VF::parseRegion, region should be given as " << param.chr << ":start-end" << std::endl;
+    exit(1);
+  }
+
+  param.region_beg = std::atoi(r.c_str() + colon + 1);
+  param.region_end = std::atoi(r.c_str() + dash + 1);
+  if (param.region_beg < 1 || param.region_end < param.region_beg)
+  {
+    std::cerr << "ERROR, VF::parseRegion, invalid region interval" << std::endl;
+    exit(1);
+  }
+  std::cout << "INFO, VF::parseRegion, region = " << param.chr << ":" << param.region_beg << "-" << param.region_end << std::endl;
+}
+
+/**
+ * @brief  parse -chr argument, 'all' or a comma separated list of ids selects
+ *         several chromosomes which are processed concurrently
+ */
+void parseChromosomes (Parameters &param)
+{
+  param.genome_wide = (param.chr == "all" || param.chr.find(',') != std::string::npos);
+  if (!param.genome_wide) return;
+
+  if (param.chr != "all")
+  {
+    std::stringstream ss (param.chr); std::string id;
+    while (std::getline(ss, id, ','))
+    {
+      if (id.length() == 0)
+      {
+        std::cerr << "ERROR, VF::parseChromosomes, chromosome ids should be given as all or id[,id...]" << std::endl;
+        exit(1);
+      }
+      if (std::find(param.chr_list.begin(), param.chr_list.end(), id) == param.chr_list.end()) param.chr_list.push_back(id);
+    }
+  }
+
+  if (param.region.length() > 0 || param.prefix.length() > 0 || param.sweep.length() > 0)
+  {
+    std::cerr << "ERROR, VF::parseChromosomes, -region, -prefix and -sweep require a single chromosome id" << std::endl;
+    exit(1);
+  }
+  if (param.cache)
+  {
+    std::cout << "INFO, VF::parseChromosomes, --cache is ignored when selecting several chromosomes" << std::endl;
+    param.cache = false;
+  }
+}
+
+/**
+ * @brief  parse optional -sweep argument, a comma separated list of
+ *         alpha:delta pairs; either side may list several values separated
+ *         by '/' to sweep over all their combinations (e.g., 500/1000:0/10)
  */
-void parseandSave(int argc, char** argv, Parameters &param)
+void parseSweep (Parameters &param)
 {
+  if (param.sweep.length() == 0) return;
+
+  auto parseValues = [&](const std::string &s, std::vector<int> &values)
+  {
+    std::stringstream ss (s); std::string v;
+    while (std::getline(ss, v, '/'))
+    {
+      if (v.length() == 0 || v.find_first_not_of("0123456789") != std::string::npos) return false;
+      values.push_back(std::atoi(v.c_str()));
+    }
+    return values.size() > 0;
+  };
+
+  std::stringstream ss (param.sweep); std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    std::size_t colon = item.find(':');
+    std::vector<int> alphas, deltas;
+    if (colon == std::string::npos || !parseValues(item.substr(0, colon), alphas) || !parseValues(item.substr(colon + 1), deltas))
+    {
+      std::cerr << "ERROR, VF::parseSweep, sweep should be given as alpha:delta[,alpha:delta...], e.g., 500:10,1000/2000:0/10" << std::endl;
+      exit(1);
+    }
+    for (auto a: alphas) for (auto d: deltas) param.sweep_points.emplace_back(a, d);
+  }
+
+  if (param.prefix.length() > 0)
+  {
+    std::cerr << "ERROR, VF::parseSweep, -prefix cannot be combined with -sweep" << std::endl;
+    exit(1);
+  }
+  std::cout << "INFO, VF::parseSweep, count of (alpha, delta) points = " << param.sweep_points.size() << std::endl;
+}
+
+/**
+ * @brief  check that alpha, or each alpha of -sweep, is at least min_alpha
+ */
+void parseAlpha (const Parameters &param, int min_alpha)
+{
+  std::vector<int> alphas (1, param.alpha);
+  if (param.sweep_points.size() > 0)
+  {
+    alphas.clear();
+    for (auto &p: param.sweep_points) alphas.push_back(p.first);
+  }
+
+  for (auto a: alphas)
+    if (a < min_alpha)
+    {
+      std::cerr << "ERROR, VF::parseAlpha, alpha should be at least " << min_alpha << ", found " << a << std::endl;
+      exit(1);
+    }
+}
+
+/**
+ * @brief  check that the count of threads is at least 1
+ */
+void parseThreads (const Parameters &param)
+{
+  if (param.threads < 1)
+  {
+    std::cerr << "ERROR, VF::parseThreads, count of threads should be at least 1, found " << param.threads << std::endl;
+    exit(1);
+  }
+}
+
+/**
+ * @brief  check that --stream is combined with options it supports, and that
+ *         vcf input from stdin ('-') is only read with --stream
+ */
+void parseStream (Parameters &param)
+{
+  if (!param.stream)
+  {
+    if (param.vcffile == "-")
+    {
+      std::cerr << "ERROR, VF::parseStream, reading vcf records from stdin requires --stream" << std::endl;
+      exit(1);
+    }
+    return;
+  }
+
+  if (param.genome_wide || param.sweep.length() > 0 || param.symmetric)
+  {
+    std::cerr << "ERROR, VF::parseStream, --stream requires a single chromosome id, -a and -d, and cannot be combined with --symmetric" << std::endl;
+    exit(1);
+  }
+  if (param.cache)
+  {
+    std::cout << "INFO, VF::parseStream, --cache is ignored with --stream" << std::endl;
+    param.cache = false;
+  }
+  std::cout << "INFO, VF::parseStream, reading position-sorted records from " << (param.vcffile == "-" ? "stdin" : param.vcffile) << std::endl;
+}
+
+/**
+ * @brief  add the optional --ac and window arguments listed in options to cli
+ */
+template <typename Group>
+void addOptions (Group &cli, Parameters &param, unsigned options)
+{
+  if (options & CLI_AC)
+    cli.push_back (clipp::option("--ac").set(param.observed).doc("count only alternate SNP alleles observed in INFO/AC (or genotypes if AC is absent)"));
+  if (options & CLI_WINDOWS)
+  {
+    cli.push_back (clipp::option("--piecewise").set(param.piecewise).doc("keep window range vectors as linear pieces, faster and smaller for large alpha with few deletions"));
+    cli.push_back (clipp::option("--symmetric").set(param.symmetric).doc("also constrain windows starting at each variant position, using right-most reachable vertices"));
+    cli.push_back (clipp::option("--blocks").set(param.blocks).doc("split variant positions where no window crosses and select within each block independently, concurrently with -t <threads>"));
+  }
+}
+
+/**
+ * @brief  parse and print command line arguments, options lists the
+ *         CLIOption values the tool supports, alpha must be at least
+ *         min_alpha (3 for the tools computing window ranges)
+ */
+void parseandSave(int argc, char** argv, Parameters &param, unsigned options, int min_alpha = 1)
+{
+    param.alpha = param.delta = 0; //unused with -sweep
     param.pos = false; //default
+    param.observed = false;
+    param.cache = false;
+    param.piecewise = false;
+    param.symmetric = false;
+    param.blocks = false;
+    param.stream = false;
+    param.threads = 1;
 
   //define all arguments
   auto cli =
     (
-     clipp::required("-a") & clipp::value("alpha", param.alpha).doc("path length in variation graph (e.g., 500)"),
-     clipp::required("-d") & clipp::value("delta", param.delta).doc("differences allowed (e.g., 10)"),
-     clipp::required("-vcf") & clipp::value("file1", param.vcffile).doc("uncompressed vcf file (something.vcf)"),
-     clipp::required("-chr") & clipp::value("id", param.chr).doc("chromosome id (e.g., 1 or chr1), make it consistent with vcf file"),
-     clipp::option("-prefix") & clipp::value("file2", param.prefix).doc("filename to optionally save input and output variants")
+     (clipp::required("-a") & clipp::value("alpha", param.alpha).doc("path length in variation graph (e.g., 500)"),
+      clipp::required("-d") & clipp::value("delta", param.delta).doc("differences allowed (e.g., 10)")) |
+     (clipp::required("-sweep") & clipp::value("points", param.sweep).doc("run all alpha:delta pairs of a comma separated list, '/' separates alternative values (e.g., 500/1000:0/10)")),
+     clipp::required("-vcf") & clipp::value("file1", param.vcffile).doc("vcf file, plain or gzip/bgzip compressed (something.vcf or something.vcf.gz)"),
+     clipp::required("-chr") & clipp::value("id", param.chr).doc("chromosome id (e.g., 1 or chr1), make it consistent with vcf file; 'all' or a comma separated list runs every chromosome concurrently"),
+     clipp::option("-prefix") & clipp::value("file2", param.prefix).doc("filename to optionally save input and output variants"),
+     clipp::option("-region") & clipp::value("region", param.region).doc("restrict to interval chr:start-end of chromosome <id> (1-based, inclusive)"),
+     clipp::option("-t") & clipp::value("threads", param.threads).doc("count of threads for parsing vcf file, computing window ranges and running sweep points, chromosomes or blocks concurrently (default 1)"),
+     clipp::option("--cache").set(param.cache).doc("reuse parsed variants and window ranges from binary cache files <file1>.vfc and <file1>.vfr, create them if missing or outdated")
     );
+  addOptions (cli, param, options);
+  if (options & CLI_STREAM)
+    cli.push_back (clipp::option("--stream").set(param.stream).doc("decide on each variant position in a single pass over position-sorted records with memory bounded by the window size, '-' as <file1> reads stdin"));
 
   if(!clipp::parse(argc, argv, cli))
   {
@@ -43,13 +262,23 @@ void parseandSave(int argc, char** argv, Parameters &param)
     exit(1);
   }
 
-  std::cout << "INFO, VF::parseandSave, alpha = " << param.alpha << std::endl;
-  std::cout << "INFO, VF::parseandSave, delta = " << param.delta << std::endl;
+  if (param.sweep.length() == 0)
+  {
+    std::cout << "INFO, VF::parseandSave, alpha = " << param.alpha << std::endl;
+    std::cout << "INFO, VF::parseandSave, delta = " << param.delta << std::endl;
+  }
   std::cout << "INFO, VF::parseandSave, vcf file = " << param.vcffile << std::endl;
   std::cout << "INFO, VF::parseandSave, chromosome id = " << param.chr << std::endl;
   if (param.prefix.length() > 0) std::cout << "INFO, VF::parseandSave, prefix = " << param.prefix << std::endl;
-
-  if (! exists(param.vcffile))
+  if (param.threads > 1) std::cout << "INFO, VF::parseandSave, threads = " << param.threads << std::endl;
+  parseChromosomes(param);
+  parseRegion(param);
+  parseSweep(param);
+  parseAlpha(param, min_alpha);
+  parseThreads(param);
+  parseStream(param);
+
+  if (! (param.stream && param.vcffile == "-") && ! exists(param.vcffile))
   {
     std::cerr << "ERROR, VF::parseandSave, vcf file cannot be opened" << std::endl;
     exit(1);
@@ -57,22 +286,36 @@ void parseandSave(int argc, char** argv, Parameters &param)
 }
 
 /**
- * @brief  parse and print command line arguments (modified for ILP)
+ * @brief  parse and print command line arguments (modified for ILP), see
+ *         parseandSave
  */
-void parseandSave_ILP(int argc, char** argv, Parameters &param)
+void parseandSave_ILP(int argc, char** argv, Parameters &param, unsigned options, int min_alpha = 1)
 {
+    param.alpha = param.delta = 0; //unused with -sweep
     param.pos = false; //default
+    param.observed = false;
+    param.cache = false;
+    param.piecewise = false;
+    param.symmetric = false;
+    param.blocks = false;
+    param.stream = false;
+    param.threads = 1;
 
   //define all arguments
   auto cli =
     (
-     clipp::required("-a") & clipp::value("alpha", param.alpha).doc("path length in variation graph (e.g., 500)"),
-     clipp::required("-d") & clipp::value("delta", param.delta).doc("differences allowed (e.g., 10)"),
-     clipp::required("-vcf") & clipp::value("file1", param.vcffile).doc("uncompressed vcf file (something.vcf)"),
-     clipp::required("-chr") & clipp::value("id", param.chr).doc("chromosome id (e.g., 1 or chr1), make it consistent with vcf file"),
+     (clipp::required("-a") & clipp::value("alpha", param.alpha).doc("path length in variation graph (e.g., 500)"),
+      clipp::required("-d") & clipp::value("delta", param.delta).doc("differences allowed (e.g., 10)")) |
+     (clipp::required("-sweep") & clipp::value("points", param.sweep).doc("run all alpha:delta pairs of a comma separated list, '/' separates alternative values (e.g., 500/1000:0/10)")),
+     clipp::required("-vcf") & clipp::value("file1", param.vcffile).doc("vcf file, plain or gzip/bgzip compressed (something.vcf or something.vcf.gz)"),
+     clipp::required("-chr") & clipp::value("id", param.chr).doc("chromosome id (e.g., 1 or chr1), make it consistent with vcf file; 'all' or a comma separated list runs every chromosome concurrently"),
      clipp::option("-prefix") & clipp::value("file2", param.prefix).doc("filename to optionally save input and output variants"),
-     clipp::option("--pos").set(param.pos).doc("set objective to minimize variation positions rather than variant count")
+     clipp::option("--pos").set(param.pos).doc("set objective to minimize variation positions rather than variant count"),
+     clipp::option("-region") & clipp::value("region", param.region).doc("restrict to interval chr:start-end of chromosome <id> (1-based, inclusive)"),
+     clipp::option("-t") & clipp::value("threads", param.threads).doc("count of threads for parsing vcf file, computing window ranges and running sweep points, chromosomes or blocks concurrently (default 1)"),
+     clipp::option("--cache").set(param.cache).doc("reuse parsed variants and window ranges from binary cache files <file1>.vfc and <file1>.vfr, create them if missing or outdated")
     );
+  addOptions (cli, param, options);
 
   if(!clipp::parse(argc, argv, cli))
   {
@@ -81,13 +324,23 @@ void parseandSave_ILP(int argc, char** argv, Parameters &param)
     exit(1);
   }
 
-  std::cout << "INFO, VF::parseandSave, alpha = " << param.alpha << std::endl;
-  std::cout << "INFO, VF::parseandSave, delta = " << param.delta << std::endl;
+  if (param.sweep.length() == 0)
+  {
+    std::cout << "INFO, VF::parseandSave, alpha = " << param.alpha << std::endl;
+    std::cout << "INFO, VF::parseandSave, delta = " << param.delta << std::endl;
+  }
   std::cout << "INFO, VF::parseandSave, vcf file = " << param.vcffile << std::endl;
   std::cout << "INFO, VF::parseandSave, chromosome id = " << param.chr << std::endl;
   if (param.prefix.length() > 0) std::cout << "INFO, VF::parseandSave, prefix = " << param.prefix << std::endl;
-
-  if (! exists(param.vcffile))
+  if (param.threads > 1) std::cout << "INFO, VF::parseandSave, threads = " << param.threads << std::endl;
+  parseChromosomes(param);
+  parseRegion(param);
+  parseSweep(param);
+  parseAlpha(param, min_alpha);
+  parseThreads(param);
+  parseStream(param);
+
+  if (! (param.stream && param.vcffile == "-") && ! exists(param.vcffile))
   {
     std::cerr << "ERROR, VF::parseandSave, vcf file cannot be opened" << std::endl;
     exit(1);
@@ -161,6 +414,44 @@ void printVariantGapStats (const std::vector<bool> &retained, const std::vector<
     std::cout<< "INFO, VF::printVariantGapStats, after: (min, mean, max) = (" << min2 << ", " << avg2 << ", " << max2 << ")\n";
 }
 
+/**
+ * @brief  running (min, mean, max) of gaps between consecutive positions,
+ *         which are added in increasing order
+ */
+struct VariantGapStats
+{
+  int last, min, max;
+  long long sum, count;
+
+  VariantGapStats () : last(-1), min(INT_MAX), max(0), sum(0), count(0) {}
+
+  void add (int pos)
+  {
+    if (last >= 0)
+    {
+      int gap = pos - last - 1;
+      min = std::min(min, gap); max = std::max(max, gap);
+      sum += gap; count++;
+    }
+    last = pos;
+  }
+};
+
+/**
+ * @brief  print gap statistics collected during a single pass, in the format
+ *         of printVariantGapStats
+ */
+void printVariantGapStats (const VariantGapStats &before, const VariantGapStats &after)
+{
+  auto print = [](const char *label, const VariantGapStats &g)
+  {
+    if (g.count == 0) return;
+    std::cout<< "INFO, VF::printVariantGapStats, " << label << ": (min, mean, max) = (" << g.min << ", " << g.sum / g.count << ", " << g.max << ")\n";
+  };
+  print ("before", before);
+  print ("after", after);
+}
+
 void print_SV_vcf (const std::vector<bool> &retained, const std::vector<int> &pos, const Parameters &param)
 {
   srand(time(0)+1); int random = rand() % 100000;  
@@ -173,8 +464,8 @@ void print_SV_vcf (const std::vector<bool> &retained, const std::vector<int> &po
   myfile1.close();
   std::cout << "INFO, VF::print_SV_vcf, written retained variant loci to " << tmp_file1 << "\n";
 
-  std::string cmd = "cat " + param.vcffile + " | grep '^#' > " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
-  cmd = "cat " + param.vcffile + " | grep -vE '^#' | grep 'INS\\|DEL' | awk -v chr=" + param.chr + " '$1 == chr {print $0}' >> " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
+  std::string cmd = "gzip -cdf " + param.vcffile + " | grep '^#' > " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
+  cmd = "gzip -cdf " + param.vcffile + " | grep -vE '^#' | grep 'INS\\|DEL' | awk -v chr=" + param.chr + " -v beg=" + std::to_string(param.region_beg) + " -v end=" + std::to_string(param.region_end) + " '$1 == chr && $2 >= beg && $2 <= end {print $0}' >> " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
 
   cmd = "cat " + param.prefix + ".inputrecords.vcf | grep '^#' > " + param.prefix + ".retainedrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
   cmd = "cat " + param.prefix + ".inputrecords.vcf | grep -vE '^#' > " + tmp_file2; std::cout << cmd << "\n"; std::system(cmd.c_str());
@@ -196,8 +487,8 @@ void print_snp_vcf (const std::vector<bool> &retained, const std::vector<int> &p
   myfile1.close();
   std::cout << "INFO, VF::print_snp_vcf, written retained variant loci to " << tmp_file1 << "\n";
 
-  std::string cmd = "cat " + param.vcffile + " | grep '^#' > " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
-  cmd = "cat " + param.vcffile + " | grep -vE '^#' | grep 'S' | awk -v chr=" + param.chr + " '$1 == chr {print $0}' >> " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
+  std::string cmd = "gzip -cdf " + param.vcffile + " | grep '^#' > " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
+  cmd = "gzip -cdf " + param.vcffile + " | grep -vE '^#' | grep 'S' | awk -v chr=" + param.chr + " -v beg=" + std::to_string(param.region_beg) + " -v end=" + std::to_string(param.region_end) + " '$1 == chr && $2 >= beg && $2 <= end {print $0}' >> " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
 
 
   cmd = "cat " + param.prefix + ".inputrecords.vcf | grep '^#' > " + param.prefix + ".retainedrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
@@ -220,8 +511,8 @@ void print_snp_indel_vcf (const std::vector<bool> &retained, const std::vector<i
   myfile1.close();
   std::cout << "INFO, VF::print_snp_indel_vcf, written retained variant loci to " << tmp_file1 << "\n";
 
-  std::string cmd = "cat " + param.vcffile + " | grep '^#' > " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
-  cmd = "cat " + param.vcffile + " | grep -vE '^#' | grep 'S\\|INS\\|DEL' | awk -v chr=" + param.chr + " '$1 == chr {print $0}' >> " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
+  std::string cmd = "gzip -cdf " + param.vcffile + " | grep '^#' > " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
+  cmd = "gzip -cdf " + param.vcffile + " | grep -vE '^#' | grep 'S\\|INS\\|DEL' | awk -v chr=" + param.chr + " -v beg=" + std::to_string(param.region_beg) + " -v end=" + std::to_string(param.region_end) + " '$1 == chr && $2 >= beg && $2 <= end {print $0}' >> " + param.prefix + ".inputrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
 
 
   cmd = "cat " + param.prefix + ".inputrecords.vcf | grep '^#' > " + param.prefix + ".retainedrecords.vcf"; std::cout << cmd << "\n"; std::system(cmd.c_str());
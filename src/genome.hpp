@@ -0,0 +1,79 @@
+#ifndef VF_GENOME_HPP
+#define VF_GENOME_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+#include <cstdlib>
+#include "thread_pool.hpp"
+
+/********* Concurrent runs over several chromosomes ******/
+
+/**
+ * @brief   run variant selection for every chromosome of chrs on a pool of
+ *          worker threads and print a per-chromosome results table followed
+ *          by the genome-wide totals. run(i) returns the result columns of
+ *          chromosome i, work[i] estimates its cost; larger chromosomes are
+ *          started first to balance the load.
+ */
+template <typename Run>
+void runChromosomes (const std::vector<std::string> &chrs, const std::vector<std::size_t> &work, int threads, const std::vector<std::string> &columns, Run run)
+{
+  assert (chrs.size() == work.size());
+
+  if (chrs.size() == 0)
+  {
+    std::cerr << "ERROR, VF::runChromosomes, count of variants found is zero, did you provide the correct vcf file and chrommosome ids?" << std::endl;
+    exit(1);
+  }
+
+  std::vector<std::vector<long>> rows (chrs.size());
+  std::vector<double> seconds (chrs.size());
+
+  std::vector<std::size_t> order (chrs.size());
+  std::iota (order.begin(), order.end(), 0);
+  std::stable_sort (order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return work[a] > work[b]; });
+
+  auto tStart = std::chrono::system_clock::now();
+  {
+    ThreadPool pool (std::min<int>(threads, chrs.size()));
+
+    std::cout << "INFO, VF::runChromosomes, running " << chrs.size() << " chromosomes" << std::endl;
+    for (auto i: order)
+    {
+      pool.submit([&, i]{
+        auto tStart = std::chrono::system_clock::now();
+        rows[i] = run(i);
+        std::chrono::duration<double> wctduration = (std::chrono::system_clock::now() - tStart);
+        seconds[i] = wctduration.count();
+      });
+    }
+    pool.wait();
+  }
+  std::chrono::duration<double> wctduration = (std::chrono::system_clock::now() - tStart);
+
+  std::vector<long> total (columns.size(), 0);
+  for (auto &r: rows)
+    for (std::size_t j = 0; j < r.size(); j++) total[j] += r[j];
+
+  std::cout << "INFO, VF::runChromosomes, results" << "\n";
+  std::cout << "chr";
+  for (auto &c: columns) std::cout << "\t" << c;
+  std::cout << "\tseconds\n";
+  for (std::size_t i = 0; i < chrs.size(); i++)
+  {
+    std::cout << chrs[i];
+    for (auto v: rows[i]) std::cout << "\t" << v;
+    std::cout << "\t" << seconds[i] << "\n";
+  }
+  std::cout << "genome";
+  for (auto v: total) std::cout << "\t" << v;
+  std::cout << "\t" << wctduration.count() << "\n";
+  std::cout << std::flush;
+}
+
+#endif
@@ -8,95 +8,229 @@
 #include <chrono>
 #include <numeric>
 #include <cstdlib>
+#include <cstring>
+#include <cassert>
 #include "common.hpp"
+#include "vcf.hpp"
+#include "sweep.hpp"
+#include "genome.hpp"
+
+/**
+ * @brief   greedy selection of SNP positions to retain, sweeping over
+ *          beginning and ending events of alpha-long windows
+ */
+void greedySelect (std::vector<bool> &R, const std::vector<int> &p, const int &alpha, const int &delta)
+{
+  int n = p.size(), i=0, j=0, count=0, event1, event2;  
 
-int main(int argc, char **argv) {
+  // Note: VCF variant positions are 1-based (i.e., they must be >=1)
 
-  //parse command line arguments
-  Parameters parameters;
-  parseandSave(argc, argv, parameters);
+  while (i < n)
+  {                                                 /* we are done when the end event of last SNP is processed */
+    event1 = std::max(1, p[i]-alpha+1);             /* position of next beginning event */
+    event2 = p[j]+1;                                /* position of next ending event */
 
-  //*********************************************************
-  // Extract SNPs and allele count from VCF
-  // seed random generator by time in seconds (this may create issue if two instances are launched at the same time)
-  srand(time(0)); int random = rand() % 100000;  
-  std::string tmp_file = ".VF." + std::to_string(random) + ".txt";
-  std::string cmd = std::string(TOSTRING(VCFTOOLSPATH)) + " --vcf " + parameters.vcffile + " --chr " + parameters.chr + " --counts --remove-indels --out " + tmp_file + " 2>/dev/null";
-  std::cout << "INFO, VF::main, extracting SNPs from vcf file using command = " << cmd << std::endl;
-  std::system(cmd.c_str());
-  std::cout << "INFO, VF::main, vcftools finished" << std::endl;
+    if(event2 <= event1) {                          /* we are processing ending event */
+      if (!R[j]) count--;
+      j++;
+    }   
 
-  //*********************************************************
-  // Reading from temp file to store c
+    if(event1 <= event2) {                          /* we are processing beginning event */
+      count++;
+      if (count > delta) {
+        R[i] = 1;
+        count--;                                    /* note the SNP position to be retained is still given by P[i] */
+      }
+      i++;
+    }
+  }       
+}
 
-  std::ifstream file(tmp_file + ".frq.count");
-  std::vector<int> p, c; 
-  std::string line;
+/**
+ * @brief   greedySelect over position-sorted SNP records read in a single
+ *          pass, each position is decided when its first record is read.
+ *          Only dropped positions within alpha of the current one are kept,
+ *          in a ring buffer of at most delta entries. Records written with
+ *          -prefix are selected as in print_snp_vcf, lines of a position are
+ *          held until the next position is read.
+ */
+void greedyStream (const Parameters &parameters)
+{
+  auto tStart = std::chrono::system_clock::now();
+  std::cout<< "INFO, VF::main, starting timer" << "\n";
+
+  VCFRegion region (parameters.chr, parameters.region_beg, parameters.region_end);
+  const int alpha = parameters.alpha, delta = parameters.delta;
+
+  //dropped positions whose ending event is not processed yet, oldest first
+  std::vector<int> dropped (std::max(delta, 1));
+  std::size_t head = 0, count = 0;
+
+  int pos = 0; bool retained = false;
+  long count_positions = 0, count_variants = 0, count_positions_retained = 0, count_variants_retained = 0;
+  VariantGapStats gaps, gaps_retained;
+
+  std::ofstream input_records, retained_records;
+  if (parameters.prefix.length() > 0)
+  {
+    input_records.open (parameters.prefix + ".inputrecords.vcf");
+    retained_records.open (parameters.prefix + ".retainedrecords.vcf");
+  }
+
+  auto header = [&](const char *line, const char *eol)
+  {
+    if (!input_records.is_open()) return;
+    input_records.write (line, eol + 1 - line);
+    retained_records.write (line, eol + 1 - line);
+  };
+
+  //record lines at line_pos selected for -prefix, i.e., containing 'S' as in print_snp_vcf
+  std::string pending; int line_pos = 0;
+  auto flush = [&]()
+  {
+    input_records << pending;
+    if (retained && line_pos == pos) retained_records << pending;
+    pending.clear();
+  };
 
-  while (std::getline(file, line))
+  auto record = [&](const char **col, const std::size_t *len, int k)
   {
-    std::string col1;
-    int col2, col3;
+    if (!inRegion (col, len, region)) return;
 
-    std::istringstream iss(line);
-    iss >> col1;
-    if (col1.compare("CHROM") != 0)  //ignore the first header line
+    int p = std::atoi(col[1]), n_alt;
+    if (p < line_pos)
     {
-      iss >> col2 >> col3;
-      p.push_back(col2);
-      c.push_back(col3 - 1);
+      std::cerr << "ERROR, VF::greedyStream, records should be sorted by position, found " << p << " after " << line_pos << std::endl;
+      exit(1);
     }
-  }
+    if (p > line_pos && input_records.is_open()) flush();
+    line_pos = p;
 
-  //keep only one record per loci
-  ignoreDuplicateSNPrecords(p, c);
-  assert (std::is_sorted(p.begin(), p.end()));
+    if (input_records.is_open() && std::memchr (col[0], 'S', col[k] - col[0]) != NULL)
+      pending.append (col[0], col[k] - col[0]).append ("\n");
+
+    if (!extractSNP (col, len, k, p, n_alt, parameters.observed)) return;
+
+    if (p > pos) //beginning event of a new position, later records at pos are ignored as in ignoreDuplicateSNPrecords
+    {
+      pos = p;
+
+      //ending events up to the beginning event of pos
+      int event1 = std::max(1, pos-alpha+1);
+      while (count > 0 && dropped[head] + 1 <= event1) { head = (head + 1) % dropped.size(); count--; }
+
+      retained = (count + 1 > (std::size_t) delta);
+      if (!retained)
+      {
+        dropped[(head + count) % dropped.size()] = pos;
+        count++;
+      }
+      else
+      {
+        count_positions_retained++; count_variants_retained += n_alt;
+        gaps_retained.add (pos);
+      }
+      count_positions++; count_variants += n_alt;
+      gaps.add (pos);
+    }
+  };
 
-  cmd = "rm -f " + tmp_file + "*";
-  std::system(cmd.c_str()); //delete tmp file
-  if (p.size() == 0)
+  VCFReader reader (parameters.vcffile);
+  const char *begin, *end;
+  while (reader.next(begin, end))
+    forEachRecordLine (begin, end, parameters.observed ? 9 : 5, header, record);
+  if (input_records.is_open()) flush();
+
+  if (count_positions == 0)
   {
-    std::cerr << "ERROR, VF::main, count of variants is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
+    std::cerr << "ERROR, VF::greedyStream, count of SNPs is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
     exit(1);
   }
+
+  std::chrono::duration<double> wctduration = (std::chrono::system_clock::now() - tStart);
+  std::cout<< "INFO, VF::main, count of variant containing positions = " << count_positions << "\n";
+  std::cout<< "INFO, VF::main, count of variants = " << count_variants << "\n";
+  std::cout<< "INFO, VF::main, time taken by variant selection algorithm = " << wctduration.count() << " seconds" << "\n";
+  std::cout<< "INFO, VF::main, count of variant containing positions retained = " << count_positions_retained << "\n";
+  std::cout<< "INFO, VF::main, count of variants retained = " << count_variants_retained << "\n";
+  printVariantGapStats (gaps, gaps_retained);
+}
+
+int main(int argc, char **argv) {
+
+  //parse command line arguments
+  Parameters parameters;
+  parseandSave(argc, argv, parameters, CLI_AC | CLI_STREAM);
+
+  if (parameters.stream)
+  {
+    greedyStream (parameters);
+    return 0;
+  }
+
+  if (parameters.genome_wide)
+  {
+    std::vector<ContigVariants> contigs;
+    parseVCF_SNP (parameters.vcffile, VCFContigs {parameters.chr_list}, contigs, parameters.threads, parameters.observed);
+
+    std::vector<std::string> chrs; std::vector<std::size_t> work;
+    for (auto &v: contigs) chrs.push_back(v.chr), work.push_back(v.pos.size());
+
+    runChromosomes (chrs, work, parameters.threads,
+        {"positions", "variants", "positions_retained", "variants_retained"},
+        [&](std::size_t k)
+        {
+          const std::vector<int> &p = contigs[k].pos, &c = contigs[k].val;
+          std::vector<bool> R(p.size(), 0);
+          greedySelect (R, p, parameters.alpha, parameters.delta);
+          long count_variants_retained = 0;
+          for (std::size_t i = 0; i < p.size(); i++) if (R[i]) count_variants_retained += c[i];
+          return std::vector<long> {(long) p.size(), std::accumulate(c.begin(), c.end(), 0L),
+                                    (long) std::count(R.begin(), R.end(), true), count_variants_retained};
+        });
+    return 0;
+  }
+
+  VCFRegion region (parameters.chr, parameters.region_beg, parameters.region_end);
+
+  //*********************************************************
+  // Extract SNPs and allele count from VCF
+
+  std::vector<int> p, c; 
+  parseVCF_SNP (parameters.vcffile, region, p, c, parameters.threads, parameters.observed, parameters.cache);
+  assert (p.size() == c.size());
   //*********************************************************
 
   std::cout<< "INFO, VF::main, count of variant containing positions = " << p.size() << "\n";
   std::cout<< "INFO, VF::main, count of variants = " << std::accumulate(c.begin(), c.end(), 0) << "\n";
 
+  if (parameters.sweep_points.size() > 0)
+  {
+    runSweep<int> (parameters.sweep_points, parameters.threads,
+        {"positions_retained", "variants_retained"},
+        [](const std::vector<int> &alphas) { return std::vector<int> (alphas.size()); },  //nothing to precompute per alpha
+        [&](int alpha, int delta, int)
+        {
+          std::vector<bool> R(p.size(), 0);
+          greedySelect (R, p, alpha, delta);
+          long count_variants_retained = 0;
+          for (std::size_t i = 0; i < p.size(); i++) if (R[i]) count_variants_retained += c[i];
+          return std::vector<long> {(long) std::count(R.begin(), R.end(), true), count_variants_retained};
+        });
+    return 0;
+  }
+
   // To track retained positions 
   std::vector<int> new_c;
-  int index;
 
   // Greedy algorithm
-  int n = p.size(), i=0, j=0, count=0, event1, event2;  
+  int n = p.size();
   std::vector<bool> R(n, 0);
 
   auto tStart = std::chrono::system_clock::now();
   std::cout<< "INFO, VF::main, starting timer" << "\n";
 
-  // Note: VCF variant positions are 1-based (i.e., they must be >=1)
-
-  // Block of greedy
-  while (i < n)
-  {                                                 /* we are done when the end event of last SNP is processed */
-    event1 = std::max(1, p[i]-parameters.alpha+1);  /* position of next beginning event */
-    event2 = p[j]+1;                                /* position of next ending event */
-
-    if(event2 <= event1) {                          /* we are processing ending event */
-      if (!R[j]) count--;
-      j++;
-    }   
-
-    if(event1 <= event2) {                          /* we are processing beginning event */
-      count++;
-      if (count > parameters.delta) {
-        R[i] = 1;
-        count--;                                    /* note the SNP position to be retained is still given by P[i] */
-      }
-      i++;
-    }
-  }       
+  greedySelect (R, p, parameters.alpha, parameters.delta);
 
   // End of greedy
 
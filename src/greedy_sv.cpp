@@ -9,214 +9,226 @@
 #include <chrono>
 #include <numeric>
 #include <cassert>
-#include <unordered_map>
+#include <deque>
 #include "ext/prettyprint.hpp"
 #include "common.hpp"
+#include "vcf.hpp"
+#include "reach_cache.hpp"
+#include "penalty.hpp"
+#include "window.hpp"
+#include "blocks.hpp"
+#include "sweep.hpp"
+#include "genome.hpp"
 
 /********* Helper functions ******/
 
 /**
- * @brief  parse VCF file to record info of insertion and deletion SVs
+ * @brief   greedy selection in a single pass over the position-sorted SV
+ *          records of the vcf file, or of stdin if it is "-". A position is
+ *          retained or dropped as soon as all of its records are read, so
+ *          memory is bounded by the windows spanning the current position
+ *          rather than by the input size. With a prefix, input and retained
+ *          records are selected as in print_SV_vcf and written as they are
+ *          decided.
  */
-void parseVCF (const std::string &sv_vcf_file, const std::string &chromosomeId, std::vector<int> &svpos, std::vector<int> &svlen)
+void greedyStream (const Parameters &parameters)
 {
-  std::ifstream file (sv_vcf_file);
-  std::string line;
-  while (std::getline(file, line))
-  {
-    if (line[0] != '#') //ignore beginning header lines 
-    {
-      int column = 0, pos, len;
-      std::string chr, type;
-      for (size_t i = 0; i < line.size() && line[i] != '\0' && line[i] != '\n'; i++) 
-      {
-        if (column == 0 && line[i] != '\t')
-          chr += line[i];
-
-        if (column == 1 && line[i-1] == '\t')
-          pos = std::atoi(&line[i]);
-
-        if (column == 7 && (std::strncmp(&line[i], "SVLEN=", 6) == 0))
-          len = std::abs((int) std::atof(&line[i + 6])); //ignore sign
-
-        if (column == 7 && strncmp(&line[i], "SVTYPE=", 7) == 0) 
-          type = std::string(&line[i + 7]);
-
-        if (line[i] == '\t') 
-          column++; //next column
-      }
-
-      if (chr == chromosomeId)
-      {
-        //only consider INSs and DELs
-        if (std::strncmp(type.c_str(), "INS", 3) == 0) 
-        {
-          svpos.push_back(pos);
-          svlen.push_back(len);
-        }
-        else if (std::strncmp(type.c_str(), "DEL", 3) == 0)
-        {
-          svpos.push_back(pos);
-          svlen.push_back(-1 * len); //negative for deletions
-        }
-      }
-    }
-  }
+  auto tStart = std::chrono::system_clock::now();
+  std::cout<< "INFO, VF::main, starting timer" << "\n";
 
-  if (svpos.size() == 0 || svlen.size() == 0)
-  {
-    std::cerr << "ERROR, VF::parseVCF, count of SVs found is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
-    exit(1);
-  }
-}
+  VCFRegion region (parameters.chr, parameters.region_beg, parameters.region_end);
+  ReachStream stream (parameters.alpha);
 
-/**
- * @brief   compute left-most reachable vertex from each variant position
- *          using up to alpha-1 labeled edges     
- */
-void calculateLeftMostReachable (std::vector<int> &reach, const std::vector<int> &svpos_u, const std::vector<int> &svpos, const std::vector<int> &svlen, const int &alpha)
-{
-  assert(alpha > 2); //the logic below requires this
-  assert (reach.size() == svpos_u.size());
+  //positions that a later window may still start at, with the penalty
+  //dropped before each of them
+  std::deque<std::pair<int, long>> window;
+  long cumulative_penalty = 0;
+  std::size_t trim_at = 1024;
 
-  /* 1. build edge-labeled graph g */
-  //reminder: vcf file contains 1-based position offsets
-  //suppose x = last position containing variant
-  //then build backbone chain of x+1 vertices
-  int g_edge_count = *(std::max_element(svpos.begin(), svpos.end())); 
-  //std::cout << "INFO, VF::calculateLeftMostReachable, max SV position recorded = " << g_edge_count << "\n";
-  std::vector<int> reach_tmp (g_edge_count+1, 0); //leftmost reachable from all vertices
+  //SV records at the current position
+  int pos = 0, max_ins_size = 0, max_del_size = 0, count = 0;
+  std::vector<int> deletions;
+  bool retained = false;
 
-  //not necessary, but bool vectors may help with faster lookup
-  std::vector<bool> out_edges (g_edge_count+1, 0);
-  std::vector<bool> in_edges (g_edge_count+1, 0);
+  long count_positions = 0, count_variants = 0, count_positions_retained = 0, count_variants_retained = 0;
+  VariantGapStats gaps, gaps_retained;
 
+  std::ofstream input_records, retained_records;
+  if (parameters.prefix.length() > 0)
+  {
+    input_records.open (parameters.prefix + ".inputrecords.vcf");
+    retained_records.open (parameters.prefix + ".retainedrecords.vcf");
+  }
 
-  //save outgoing neighbors associated with unlabeled deletion edges only
-  std::unordered_map<int,std::vector<int>> g_out_d_neighbors;
-  for (std::size_t i = 0; i < svpos.size(); i++)
+  auto decide = [&]()
   {
-    if (svlen[i] < 0) //only deletions
+    int reach = stream.reach(pos);
+    for (auto to: deletions) stream.addDeletion (pos, to);
+
+    //penalty already incurred within window (reach, pos]
+    auto l = std::upper_bound (window.begin(), window.end(), reach, [](int r, const std::pair<int, long> &w) { return r < w.first; });
+    long penalty_already_incurred = (l == window.end()) ? 0 : cumulative_penalty - l->second;
+    window.emplace_back (pos, cumulative_penalty);
+
+    int pen = max_ins_size + max_del_size;
+    retained = (penalty_already_incurred + pen > parameters.delta);
+    if (!retained)
+      cumulative_penalty += pen; //drop
+    else
     {
-      //add deletion edge from svpos[i] to svpos[i] + |svlen[i]|
-      int from = svpos[i]; int to = svpos[i] + std::abs(svlen[i]);
-
-      out_edges[from] = true, in_edges[to] = true;
-
-      if (g_out_d_neighbors.find(from) != g_out_d_neighbors.end()) //search
-        g_out_d_neighbors[from].push_back(to);   //add 'to'
-      else
-        g_out_d_neighbors[from] = std::vector<int> {to}; //initialize
+      count_positions_retained++; count_variants_retained += count; //retain
+      gaps_retained.add (pos);
     }
-  }
+    count_positions++; count_variants += count;
+    gaps.add (pos);
 
-  //initialize vector of size alpha - 1
-  //first value signifies vertex reachable using 1 edge, second using 2 edges and so on
-  std::vector<int> currentPos (alpha-1);
-  std::vector<int>  previousPos (alpha-1);
+    if (window.size() > trim_at)
+    {
+      int f = stream.floor();
+      while (!window.empty() && window.front().first <= f) window.pop_front();
+      trim_at = std::max<std::size_t>(1024, 2 * window.size());
+    }
 
-  //each vertex sends update using its out-going (unlabeled) edge
-  //these updates are maintained in a hash table, until the vertex is visited
-  std::unordered_map<int, std::vector<int>> updateAhead;
+    max_ins_size = max_del_size = count = 0;
+    deletions.clear();
+  };
 
-  std::cout << "INFO, VF::calculateLeftMostReachable, computing window ranges...\n" << std::flush;
+  auto header = [&](const char *line, const char *eol)
+  {
+    if (!input_records.is_open()) return;
+    input_records.write (line, eol + 1 - line);
+    retained_records.write (line, eol + 1 - line);
+  };
+
+  //record lines at line_pos selected for -prefix, i.e., containing INS or DEL as in print_SV_vcf
+  static const std::string ins = "INS", del = "DEL";
+  std::string pending; int line_pos = 0;
+  auto flush = [&]()
+  {
+    input_records << pending;
+    if (retained && line_pos == pos) retained_records << pending;
+    pending.clear();
+  };
 
-  for (std::size_t i = 1; i <= g_edge_count; i++)
+  auto record = [&](const char **col, const std::size_t *len, int k)
   {
-    if (i == 1) //base case
+    if (!inRegion (col, len, region)) return;
+
+    int p = std::atoi(col[1]), sz;
+    if (p < line_pos)
     {
-      std::fill (currentPos.begin(), currentPos.end(), 1); //can only reach 1st vertex
+      std::cerr << "ERROR, VF::greedyStream, records should be sorted by position, found " << p << " after " << line_pos << std::endl;
+      exit(1);
     }
-    else
+    if (p > line_pos)
     {
-      //use labeled edge
-      std::memmove(&currentPos[1], &currentPos[0], (alpha-2)*sizeof(int)); //right shift by 1
-      currentPos[0] = i - 1;  // vertex i-1 is reachable using one edge
-
-      //use updates sent via in-coming unlabeled edges
-      if (in_edges[i])
-      {
-        assert (updateAhead.find(i) != updateAhead.end());
-
-        //take pairwise minimum with vector saved at updateAhead[i]
-        std::transform (updateAhead[i].begin(), updateAhead[i].end(),
-            currentPos.begin(), currentPos.begin(), [&](int a, int b){return std::min(a,b);});
-
-        updateAhead.erase(i); //no longer needed
-      }
+      if (count > 0) decide();
+      if (input_records.is_open()) flush();
     }
+    line_pos = p;
 
-    //check unlabelled outgoing edges going *out* of vertex position i
-    if (out_edges[i]) //check adjacency list
-    {
-      assert (g_out_d_neighbors.find(i) != g_out_d_neighbors.end());
-
-      for (auto &v: g_out_d_neighbors[i]) //iterate over all out-going vertices
-      {
-        assert (v>i);
-
-        if (updateAhead.find(v) == updateAhead.end())
-          updateAhead[v] = std::vector<int> (alpha-1, v); //initialize
+    if (input_records.is_open() && (std::search (col[0], col[k], ins.begin(), ins.end()) != col[k] || std::search (col[0], col[k], del.begin(), del.end()) != col[k]))
+      pending.append (col[0], col[k] - col[0]).append ("\n");
 
-        assert (currentPos.size() == updateAhead[v].size());
+    if (!extractSV (col, len, k, p, sz)) return;
+    pos = p;
 
-        //take pairwise minimum with vector currentPos
-        std::transform (currentPos.begin(), currentPos.end(),
-            updateAhead[v].begin(), updateAhead[v].begin(), [&](int a, int b){return std::min(a,b);});
-      }
+    if (sz > 0)
+      max_ins_size = std::max(max_ins_size, sz);
+    else
+    {
+      max_del_size = std::max(max_del_size, std::abs(sz));
+      deletions.push_back(p + std::abs(sz));
     }
+    count++;
+  };
 
-    reach_tmp[i] = currentPos[alpha-2]; //this is the last value in currentPos vector
-  }
+  VCFReader reader (parameters.vcffile);
+  const char *begin, *end;
+  while (reader.next(begin, end))
+    forEachRecordLine (begin, end, 8, header, record);
+  if (count > 0) decide();
+  if (input_records.is_open()) flush();
 
-  std::cout << "INFO, VF::calculateLeftMostReachable, done" << std::endl;
+  if (count_positions == 0)
+  {
+    std::cerr << "ERROR, VF::greedyStream, count of SVs found is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
+    exit(1);
+  }
 
-  //we need reachability info only for variant positions
-  for (std::size_t i = 0; i < reach.size(); i++)
-    reach[i] = reach_tmp[svpos_u[i]];
+  std::chrono::duration<double> wctduration = (std::chrono::system_clock::now() - tStart);
+  std::cout<< "INFO, VF::main, count of variant containing positions = " << count_positions << "\n";
+  std::cout<< "INFO, VF::main, count of variants = " << count_variants << "\n";
+  std::cout<< "INFO, VF::main, time taken by variant selection algorithm = " << wctduration.count() << " seconds" << "\n";
+  std::cout<< "INFO, VF::main, count of variant containing positions retained = " << count_positions_retained << "\n";
+  std::cout<< "INFO, VF::main, count of variants retained = " << count_variants_retained << "\n";
+  printVariantGapStats (gaps, gaps_retained);
 }
 
-/**
- * @brief   Compute penalty associated with dropping variants at each position.
- *          This function also computes c vector along side penalties.
- */
-void calculatePenalty (std::vector<int> &penalty, std::vector<int> &c, const std::vector<int> &svpos_u, const std::vector<int> &svpos, const std::vector<int> &svlen)
-{
-  assert(penalty.size() == svpos_u.size());
+int main(int argc, char **argv) {
 
-  int g_edge_count = *(std::max_element(svpos.begin(), svpos.end())); 
-  std::vector<int> max_ins_size (g_edge_count+1, 0);
-  std::vector<int> max_del_size (g_edge_count+1, 0);
-  std::vector<int> count (g_edge_count+1, 0);
+  //parse command line arguments
+  Parameters parameters;
+  parseandSave(argc, argv, parameters, CLI_WINDOWS | CLI_STREAM, 3); //window ranges require alpha > 2
 
-  for (std::size_t i = 0; i < svpos.size(); i++)
+  if (parameters.stream)
   {
-    if (svlen[i] > 0)
-      max_ins_size[svpos[i]] = std::max(max_ins_size[svpos[i]], svlen[i]);
-    else
-      max_del_size[svpos[i]] = std::max(max_del_size[svpos[i]], std::abs(svlen[i]));
-
-    count[svpos[i]]++;
+    greedyStream (parameters);
+    return 0;
   }
 
-  for (std::size_t i = 0; i < penalty.size(); i++)
+  if (parameters.genome_wide)
   {
-    penalty[i] = max_ins_size[svpos_u[i]] + max_del_size[svpos_u[i]];
-    c[i] = count[svpos_u[i]];
-  }
-}
+    std::vector<ContigVariants> contigs;
+    parseVCF (parameters.vcffile, VCFContigs {parameters.chr_list}, contigs, parameters.threads);
 
-int main(int argc, char **argv) {
+    std::vector<std::string> chrs; std::vector<std::size_t> work;
+    for (auto &v: contigs) chrs.push_back(v.chr), work.push_back(v.pos.size());
 
-  //parse command line arguments
-  Parameters parameters;
-  parseandSave(argc, argv, parameters);
+    runChromosomes (chrs, work, parameters.threads,
+        {"positions", "variants", "positions_retained", "variants_retained"},
+        [&](std::size_t k)
+        {
+          const std::vector<int> &svpos = contigs[k].pos, &svlen = contigs[k].val;
+          assert (std::is_sorted(svpos.begin(), svpos.end())); //must be sorted in ascending order
+
+          std::vector<int> svpos_u;
+          std::unique_copy(svpos.begin(), svpos.end(), std::back_inserter(svpos_u));
+          int n = svpos_u.size();
+
+          std::vector<int> reach (n), penalty (n), c (n, 0);
+          calculateLeftMostReachable (reach, svpos_u, svpos, svlen, parameters.alpha, 1, parameters.piecewise);
+          calculatePenalty (penalty, c, svpos_u, svpos, svlen);
+
+          Windows right;
+          if (parameters.symmetric)
+          {
+            std::vector<int> reach_right (n);
+            calculateRightMostReachable (reach_right, svpos_u, svpos, svlen, parameters.alpha, 1, parameters.piecewise);
+            rightWindows (right, reach_right, svpos_u);
+          }
+
+          std::vector<bool> R(n, 0);
+          std::vector<int> start;
+          leftWindowStarts (start, reach, svpos_u);
+          if (parameters.blocks)
+            greedySelectBlocks (R, start, right, penalty, parameters.delta, 1);
+          else
+            greedySelect (R, start, right, penalty, parameters.delta);
+          long count_variants_retained = 0;
+          for (std::size_t i = 0; i < n; i++) if(R[i]) count_variants_retained += c[i];
+          return std::vector<long> {(long) n, (long) svpos.size(), (long) std::count(R.begin(), R.end(), true), count_variants_retained};
+        });
+    return 0;
+  }
+
+  VCFRegion region (parameters.chr, parameters.region_beg, parameters.region_end);
 
   //*********************************************************
   // Reading from file to store c
 
   std::vector<int> svpos, svlen; 
-  parseVCF (parameters.vcffile, parameters.chr, svpos, svlen); 
+  parseVCF (parameters.vcffile, region, svpos, svlen, parameters.threads, parameters.cache);
   assert (svpos.size() == svlen.size());
   assert (std::is_sorted(svpos.begin(), svpos.end())); //must be sorted in ascending order
   //*********************************************************
@@ -231,6 +243,43 @@ int main(int argc, char **argv) {
   std::cout<< "INFO, VF::main, count of variant containing positions = " << svpos_u.size() << "\n";
   std::cout<< "INFO, VF::main, count of variants = " << svpos.size() << "\n";
 
+  if (parameters.sweep_points.size() > 0)
+  {
+    //compute penalty of variant removal for each position, independent of alpha and delta
+    std::vector<int> penalty (n);
+    calculatePenalty (penalty, c, svpos_u, svpos, svlen);
+
+    runSweep<WindowRanges> (parameters.sweep_points, parameters.threads,
+        {"positions_retained", "variants_retained"},
+        [&](const std::vector<int> &alphas)
+        {
+          std::vector<std::vector<int>> reach, reach_right;
+          calculateLeftMostReachable (reach, svpos_u, svpos, svlen, alphas, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+          if (parameters.symmetric)
+            calculateRightMostReachable (reach_right, svpos_u, svpos, svlen, alphas, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+
+          std::vector<WindowRanges> ranges (alphas.size());
+          for (std::size_t a = 0; a < alphas.size(); a++)
+          {
+            leftWindowStarts (ranges[a].start, reach[a], svpos_u);
+            if (parameters.symmetric) rightWindows (ranges[a].right, reach_right[a], svpos_u);
+          }
+          return ranges;
+        },
+        [&](int /*alpha*/, int delta, const WindowRanges &ranges)
+        {
+          std::vector<bool> R(n, 0);
+          if (parameters.blocks)
+            greedySelectBlocks (R, ranges.start, ranges.right, penalty, delta, 1);
+          else
+            greedySelect (R, ranges.start, ranges.right, penalty, delta);
+          long count_variants_retained = 0;
+          for (std::size_t i = 0; i < n; i++) if(R[i]) count_variants_retained += c[i];
+          return std::vector<long> {(long) std::count(R.begin(), R.end(), true), count_variants_retained};
+        });
+    return 0;
+  }
+
   // Greedy algorithm
 
   auto tStart = std::chrono::system_clock::now();
@@ -238,38 +287,26 @@ int main(int argc, char **argv) {
 
   //compute reachability
   std::vector<int> reach (n);
-  calculateLeftMostReachable (reach, svpos_u, svpos, svlen, parameters.alpha); 
+  calculateLeftMostReachable (reach, svpos_u, svpos, svlen, parameters.alpha, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+
+  Windows right;
+  if (parameters.symmetric)
+  {
+    std::vector<int> reach_right (n);
+    calculateRightMostReachable (reach_right, svpos_u, svpos, svlen, parameters.alpha, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+    rightWindows (right, reach_right, svpos_u);
+  }
 
   //compute penalty of variant removal for each position
   std::vector<int> penalty (n);
   calculatePenalty (penalty, c, svpos_u, svpos, svlen);
 
-  // Block of greedy
-  std::vector<int> cumulative_penalty (n,0); 
-  //cumulative_penalty[i] indicates cumulative penalty until svpos_u[i] (exclusive)
-  for (std::size_t i = 0; i < n; i++)
-  {
-    //penalty to drop svpos_u[i]
-    int pen = penalty[i];
-
-    //check range
-    auto leftMostVariantPos_it = std::upper_bound (svpos_u.begin(), svpos_u.end(), reach[i]);
-    auto leftMostVariantPos_index = leftMostVariantPos_it - svpos_u.begin();
-
-    int penalty_already_incurred = cumulative_penalty[i] - cumulative_penalty[leftMostVariantPos_index];
-
-    if (penalty_already_incurred + pen <= parameters.delta)
-    {
-      if (i < n-1)
-        cumulative_penalty[i+1] = cumulative_penalty[i] + pen; //drop
-    }
-    else
-    {
-      R[i] = true; //retain
-      if (i < n-1)
-        cumulative_penalty[i+1] = cumulative_penalty[i];
-    }
-  }
+  std::vector<int> start;
+  leftWindowStarts (start, reach, svpos_u);
+  if (parameters.blocks)
+    greedySelectBlocks (R, start, right, penalty, parameters.delta, parameters.threads, true);
+  else
+    greedySelect (R, start, right, penalty, parameters.delta);
 
   // End of greedy
 
@@ -282,6 +319,11 @@ int main(int argc, char **argv) {
   for (std::size_t i = 0; i < n; i++) if(R[i]) count_variants_retained += c[i]; 
   std::cout<< "INFO, VF::main, count of variants retained = " << count_variants_retained << "\n";
 
+  //check all maximal windows in one pass
+  Windows windows;
+  constraintWindows (windows, start, right);
+  printWindowCheck (R, penalty, windows, parameters.delta);
+
   printVariantGapStats (R, svpos_u);
   if (parameters.prefix.length() > 0) print_SV_vcf (R, svpos_u, parameters);
 
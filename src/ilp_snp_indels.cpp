@@ -9,289 +9,224 @@
 #include <chrono>
 #include <numeric>
 #include <cassert>
-#include <unordered_map>
+#include <atomic>
 #include "ext/prettyprint.hpp"
 #include "common.hpp"
+#include "vcf.hpp"
+#include "reach_cache.hpp"
+#include "penalty.hpp"
+#include "window.hpp"
+#include "blocks.hpp"
+#include "sweep.hpp"
+#include "genome.hpp"
 #include "gurobi_c++.h"
 
 /********* Helper functions ******/
 
 /**
- * @brief  parse VCF file to record info of insertion and deletion SVs
+ * @brief   solve ILP to decide variant positions to retain, maximizing the
+ *          count of dropped variants (or positions if pos is set) such that
+ *          penalty of dropped positions within each window stays within delta,
+ *          one constraint row per maximal window. threads limits the Gurobi
+ *          threads (0 leaves the default), quiet suppresses all output
  */
-void parseVCF_indel (const std::string &vcf_file, const std::string &chromosomeId, std::vector<int> &indelpos, std::vector<int> &indellen)
-{  
-  // Extract indels from VCF
-  // seed random generator by time in seconds (this may create issue if two instances are launched at the same time)
-  srand(time(0)); int random = rand() % 100000;  
-  std::string tmp_file = ".VF." + std::to_string(random) + ".txt";
-  //the following command assumes that vcf record will contain "VT=INDEL" for indel variants
-  std::string cmd = " grep \"VT=INDEL\" " + vcf_file + " >  " + tmp_file;
-  std::cout << "INFO, VF::main, extracting indels from vcf file using command: " << cmd << std::endl;
-  std::system(cmd.c_str());
-  std::cout << "INFO, VF::main, grep finished" << std::endl;
-
-  std::ifstream file (tmp_file);
-  std::string line;
-  while (std::getline(file, line))
-  {
-    if (line[0] != '#') //ignore beginning header lines 
-    {
-      std::string col1, col3, col4, col5;
-      int col2;
-
-      std::istringstream iss(line);
-      iss >> col1 >> col2 >> col3 >> col4 >> col5;
-
-      if (col1.compare(chromosomeId) == 0)
-      {
-        //ref and alt sequences should only contain alphabetic letter
-        assert( std::all_of(std::begin(col4), std::end(col4),
-                [](char c){ return std::isalpha(c); }));
-
-        assert( std::all_of(std::begin(col5), std::end(col5),
-                [](char c){ return std::isalpha(c); }));
-
-        int var_size = col5.length() - col4.length(); //alt - ref, -ve if deletion, +ve for insertion
-        if (var_size != 0)
-        {
-          indelpos.push_back(col2);
-          indellen.push_back(var_size);
-        }
-      }
-    }
-  }
+void solveILP (std::vector<bool> &R, const Windows &windows, const std::vector<int> &penalty, const std::vector<int> &c, const std::vector<int> &pos_u, const int &delta, const bool &pos, int threads = 0, bool quiet = false)
+{
+  int n = pos_u.size();
+  GRBVar* x = 0;
 
-  if (indelpos.size() == 0 || indellen.size() == 0)
+  try
   {
-    std::cerr << "ERROR, VF::parseVCF_indel, count of indels found is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
-    exit(1);
-  }
-
-  cmd = "rm -f " + tmp_file + "*";
-  std::system(cmd.c_str()); //delete tmp file
-}
+    //Gurobi modeling
+    if (!quiet) std::cout<< "INFO, VF::solveILP, Gurobi solver starting" << "\n";
+    GRBEnv env (quiet);
+    if (quiet) { env.set(GRB_IntParam_OutputFlag, 0); env.start(); }
+    GRBModel model = GRBModel(env);
 
-/**
- * @brief  parse VCF file to record info of insertion and deletion SVs
- */
-void parseVCF_SNP (const std::string &vcf_file, const std::string &chromosomeId, std::vector<int> &snppos, std::vector<int> &snpcount)
-{
-  srand(time(0)); int random = rand() % 100000;  
-  std::string tmp_file = ".VF." + std::to_string(random) + ".txt";
-  std::string cmd = std::string(TOSTRING(VCFTOOLSPATH)) + " --vcf " + vcf_file + " --chr " + chromosomeId + " --counts --remove-indels --out " + tmp_file + " 2>/dev/null";
-  std::cout << "INFO, VF::main, extracting SNPs from vcf file using command: " << cmd << std::endl;
-  std::system(cmd.c_str());
-  std::cout << "INFO, VF::main, vcftools finished" << std::endl;
+    //comment out this line to enable Gurobi output log
+    model.set(GRB_IntParam_LogToConsole, 0);
+    if (threads > 0) model.set(GRB_IntParam_Threads, threads);
 
-  //*********************************************************
-  // Reading from temp file to store c
+    // Create variables
+    std::vector<double> zeros (n, 0.0);
+    std::vector<double> ones (n, 1.0);
+    std::vector<char> type (n, GRB_BINARY);
 
-  std::ifstream file(tmp_file + ".frq.count");
-  std::string line;
+    x = model.addVars(zeros.data(), ones.data(), NULL, type.data(), NULL, n);
 
-  while (std::getline(file, line))
-  {
-    std::string col1;
-    int col2, col3;
+    // Set objective
+    GRBLinExpr obj = 0;
 
-    std::istringstream iss(line);
-    iss >> col1;
-    if (col1.compare("CHROM") != 0)  //ignore the first header line
+    if (!quiet)
     {
-      iss >> col2 >> col3;
-      snppos.push_back(col2);
-      snpcount.push_back(col3 - 1);
+      if (pos)
+        std::cout << "INFO, VF::solveILP, ILP solver will attempt to minimize variant positions" << "\n";
+      else
+        std::cout << "INFO, VF::solveILP, ILP solver will attempt to minimize count of variants " << "\n";
     }
-  }
-
-  //keep only one record per loci
-  ignoreDuplicateSNPrecords(snppos, snpcount);
-  assert (std::is_sorted(snppos.begin(), snppos.end()));
 
-  cmd = "rm -f " + tmp_file + "*";
-  std::system(cmd.c_str()); //delete tmp file
-  if (snppos.size() == 0)
-  {
-    std::cerr << "ERROR, VF::parseVCF_SNP, count of SNPs is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
-    exit(1);
-  }
-}
-
-/**
- * @brief   compute left-most reachable vertex from each variant position
- *          using up to alpha-1 labeled edges     
- */
-void calculateLeftMostReachable (std::vector<int> &reach, const std::vector<int> &pos_u, const std::vector<int> &indelpos, const std::vector<int> &indellen, const int &alpha)
-{
-  assert(alpha > 2); //the logic below requires this
-  assert (reach.size() == pos_u.size());
-
-  /* 1. build edge-labeled graph g */
-  //reminder: vcf file contains 1-based position offsets
-  //suppose x = last position containing variant
-  //then build backbone chain of x+1 vertices
-  int g_edge_count = *(std::max_element(pos_u.begin(), pos_u.end())); 
-  //std::cout << "INFO, VF::calculateLeftMostReachable, max SV position recorded = " << g_edge_count << "\n";
-  std::vector<int> reach_tmp (g_edge_count+1, 0); //leftmost reachable from all vertices
-
-  //not necessary, but bool vectors may help with faster lookup
-  std::vector<bool> out_edges (g_edge_count+1, 0);
-  std::vector<bool> in_edges (g_edge_count+1, 0);
-
-  //save outgoing neighbors associated with unlabeled deletion edges only
-  std::unordered_map<int,std::vector<int>> g_out_d_neighbors;
-  for (std::size_t i = 0; i < indelpos.size(); i++)
-  {
-    if (indellen[i] < 0) //only deletions
+    for (int i = 0; i < n; i++)
     {
-      //add deletion edge from svpos[i] to svpos[i] + |svlen[i]|
-      int from = indelpos[i]; int to = indelpos[i] + std::abs(indellen[i]);
-
-      out_edges[from] = true, in_edges[to] = true;
-
-      if (g_out_d_neighbors.find(from) != g_out_d_neighbors.end()) //search
-        g_out_d_neighbors[from].push_back(to);   //add 'to'
+      if (pos)
+        obj += 1*x[i];
       else
-        g_out_d_neighbors[from] = std::vector<int> {to}; //initialize
+        obj += c[i]*x[i];
     }
-  }
 
-  //initialize vector of size alpha - 1
-  //first value signifies vertex reachable using 1 edge, second using 2 edges and so on
-  std::vector<int> currentPos (alpha-1);
-  std::vector<int>  previousPos (alpha-1);
+    //maximize c.x
+    model.setObjective(obj, GRB_MAXIMIZE);
 
-  //each vertex sends update using its out-going (unlabeled) edge
-  //these updates are maintained in a hash table, until the vertex is visited
-  std::unordered_map<int, std::vector<int>> updateAhead;
+    // Add constraints, windows contained in others are implied by them
+    if (!quiet) std::cout << "INFO, VF::solveILP, adding " << windows.size() << " window constraints for " << n << " variant positions" << "\n";
+    for (std::size_t k = 0; k < windows.size(); k++)
+    {
+      GRBLinExpr lhs = 0;
 
-  std::cout << "INFO, VF::calculateLeftMostReachable, computing window ranges...\n" << std::flush;
+      for (int j = windows.end[k]; j >= windows.beg[k]; j--)
+        lhs += penalty[j] * x[j];
 
-  for (std::size_t i = 1; i <= g_edge_count; i++)
-  {
-    if (i == 1) //base case
-    {
-      std::fill (currentPos.begin(), currentPos.end(), 1); //can only reach 1st vertex
+      model.addConstr(lhs , GRB_LESS_EQUAL, 1.0 * delta);
+      //this adds each contraint row of A.x <= b one by one
     }
-    else
-    {
-      //use labeled edge
-      std::memmove(&currentPos[1], &currentPos[0], (alpha-2)*sizeof(int)); //right shift by 1
-      currentPos[0] = i - 1;  // vertex i-1 is reachable using one edge
 
-      //use updates sent via in-coming unlabeled edges
-      if (in_edges[i])
-      {
-        assert (updateAhead.find(i) != updateAhead.end());
+    model.optimize();
 
-        //take pairwise minimum with vector saved at updateAhead[i]
-        std::transform (updateAhead[i].begin(), updateAhead[i].end(),
-            currentPos.begin(), currentPos.begin(), [&](int a, int b){return std::min(a,b);});
+    if (model.get(GRB_IntAttr_Status) == GRB_OPTIMAL && !quiet) {
+      double objval = model.get(GRB_DoubleAttr_ObjVal);
+      std::cout << "Optimal objective: " << objval << std::endl;
+    } 
 
-        updateAhead.erase(i); //no longer needed
-      }
+    // To store variant positions retained
+    for(int i =0; i < n; i++){
+      if(x[i].get(GRB_DoubleAttr_X) < 0.5)
+        R[i] = true;
     }
-
-    //check unlabelled outgoing edges going *out* of vertex position i
-    if (out_edges[i]) //check adjacency list
+    delete[] x;
+  } 
+  catch (GRBException e) {
+    std::cout << "ERROR, VF::solveILP, Gurobi exception raised, error code = " << e.getErrorCode() << ", ";
+    std::cout << e.getMessage() << std::endl;
+    if (e.getErrorCode() == 10009)
     {
-      assert (g_out_d_neighbors.find(i) != g_out_d_neighbors.end());
-
-      for (auto &v: g_out_d_neighbors[i]) //iterate over all out-going vertices
-      {
-        assert (v>i);
-
-        if (updateAhead.find(v) == updateAhead.end())
-          updateAhead[v] = std::vector<int> (alpha-1, v); //initialize
-
-        assert (currentPos.size() == updateAhead[v].size());
-
-        //take pairwise minimum with vector currentPos
-        std::transform (currentPos.begin(), currentPos.end(),
-            updateAhead[v].begin(), updateAhead[v].begin(), [&](int a, int b){return std::min(a,b);});
-      }
+      std::cout << "Step1. Get your free Gurobi academic license code by registering here: https://www.gurobi.com/downloads/end-user-license-agreement-academic" << std::endl;
+      std::cout << "Step2. Add your licence key by using build/gurobi910/linux64/bin/grbgetkey tool" << std::endl;
     }
-
-    reach_tmp[i] = currentPos[alpha-2]; //this is the last value in currentPos vector
+    exit(1);
+  } 
+  catch (...) {
+    std::cout << "Error during optimization" << std::endl;
+    exit(1);
   }
-
-  std::cout << "INFO, VF::calculateLeftMostReachable, done" << std::endl;
-
-  //we need reachability info only for variant positions
-  for (std::size_t i = 0; i < reach.size(); i++)
-    reach[i] = reach_tmp[pos_u[i]];
-
 }
 
 /**
- * @brief   Compute penalty associated with dropping variants at each position.
- *          This function also computes c vector along side penalties.
+ * @brief   solveILP on each independent block of windows, see
+ *          independentBlocks. Blocks where dropping all positions satisfies
+ *          every window skip the solver, the others are solved as separate
+ *          smaller models on a pool of threads.
  */
-void calculatePenalty (std::vector<int> &penalty, std::vector<int> &c, std::vector<int> &c_snp, const std::vector<int> &pos_u, const std::vector<int> &indelpos, const std::vector<int> &indellen, const std::vector<int> &snppos, const std::vector<int> &snpcount)
+void solveILPBlocks (std::vector<bool> &R, const Windows &windows, const std::vector<int> &penalty, const std::vector<int> &c, const std::vector<int> &pos_u, const int &delta, const bool &pos, int threads, bool verbose = false)
 {
-  assert(penalty.size() == pos_u.size());
+  Windows blocks;
+  independentBlocks (blocks, windows, pos_u.size());
+  if (verbose) printBlocks (blocks);
 
-  int g_edge_count = *(std::max_element(pos_u.begin(), pos_u.end())); 
-  std::vector<int> max_ins_size (g_edge_count+1, 0);
-  std::vector<int> max_del_size (g_edge_count+1, 0);
-  std::vector<bool> snp_present (g_edge_count+1, false);
-  std::vector<int> count (g_edge_count+1, 0);
-  std::vector<int> count_snp (g_edge_count+1, 0);
-
-  for (std::size_t i = 0; i < indelpos.size(); i++)
+  std::atomic<int> solved (0);
+  selectBlocks (R, blocks, threads, [&](int beg, int end, std::vector<bool> &R_block)
   {
-    if (indellen[i] > 0)
-      max_ins_size[indelpos[i]] = std::max(max_ins_size[indelpos[i]], indellen[i]);
-    else
-      max_del_size[indelpos[i]] = std::max(max_del_size[indelpos[i]], std::abs(indellen[i]));
-    count[indelpos[i]]++;
-  }
+    Windows windows_block;
+    sliceWindows (windows_block, windows, beg, end);
+    std::vector<int> penalty_block (penalty.begin() + beg, penalty.begin() + end + 1);
+    if (verifyWindows (R_block, penalty_block, windows_block, delta) == 0) return; //drop all
+
+    std::vector<int> c_block (c.begin() + beg, c.begin() + end + 1), pos_block (pos_u.begin() + beg, pos_u.begin() + end + 1);
+    solveILP (R_block, windows_block, penalty_block, c_block, pos_block, delta, pos, threads > 1 ? 1 : 0, true);
+    solved++;
+  });
+  if (verbose) std::cout << "INFO, VF::solveILPBlocks, solved " << solved << " blocks with Gurobi, dropped all positions of the others" << "\n";
+}
 
-  for (std::size_t i = 0; i < snppos.size(); i++)
-  {
-    snp_present[snppos[i]] = true;
-    count[snppos[i]] += snpcount[i];
-    count_snp[snppos[i]] += snpcount[i];
-  }
+int main(int argc, char **argv) {
+
+  //parse command line arguments
+  Parameters parameters;
+  parseandSave_ILP(argc, argv, parameters, CLI_AC | CLI_WINDOWS, 3); //window ranges require alpha > 2
 
-  for (std::size_t i = 0; i < penalty.size(); i++)
+  if (parameters.genome_wide)
   {
-    if (max_del_size[pos_u[i]] > 0)
+    std::vector<ContigVariants> indels, snps;
+    parseVCF_indel_SNP (parameters.vcffile, VCFContigs {parameters.chr_list}, indels, snps, parameters.threads, parameters.observed);
+
+    //chromosomes with at least one indel or SNP
+    std::vector<std::string> chrs; std::vector<std::size_t> work;
+    std::vector<const ContigVariants*> indels_of, snps_of;
+    ContigVariants none;
+    auto lookup = [&](const std::vector<ContigVariants> &v, const std::string &chr) -> const ContigVariants*
     {
-      //deletion penalty subsumes SNP penalty
-      penalty[i] = max_ins_size[pos_u[i]] + max_del_size[pos_u[i]];
-    }
-    else
+      for (auto &x: v) if (x.chr == chr) return &x;
+      return &none;
+    };
+    for (auto &v: indels) chrs.push_back(v.chr);
+    for (auto &v: snps) if (lookup(indels, v.chr) == &none) chrs.push_back(v.chr);
+    for (auto &chr: chrs)
     {
-      if (snp_present[pos_u[i]] == true)
-        penalty[i] = max_ins_size[pos_u[i]] + 1;
-      else
-        penalty[i] = max_ins_size[pos_u[i]];
+      indels_of.push_back(lookup(indels, chr)); snps_of.push_back(lookup(snps, chr));
+      work.push_back(indels_of.back()->pos.size() + snps_of.back()->pos.size());
     }
 
-    c[i] = count[pos_u[i]];
-    c_snp[i] = count_snp[pos_u[i]];
-
-    assert (penalty[i] > 0);
-    assert (c[i] > 0);
-    if (snp_present[pos_u[i]]) assert (c_snp[i] > 0);
+    runChromosomes (chrs, work, parameters.threads,
+        {"positions", "variants", "positions_retained", "variants_retained", "snp_variants_retained", "indel_variants_retained"},
+        [&](std::size_t k)
+        {
+          const std::vector<int> &indelpos = indels_of[k]->pos, &indellen = indels_of[k]->val;
+          const std::vector<int> &snppos = snps_of[k]->pos, &snpcount = snps_of[k]->val;
+
+          //variant positions (unique values)
+          std::vector<int> pos_u;
+          pos_u.insert (pos_u.end(), indelpos.begin(), indelpos.end());
+          pos_u.insert (pos_u.end(), snppos.begin(), snppos.end());
+          std::sort (pos_u.begin(), pos_u.end());
+          pos_u.erase(std::unique(pos_u.begin(), pos_u.end()), pos_u.end() );
+          int n = pos_u.size();
+
+          std::vector<int> reach (n), penalty (n), c (n, 0), c_snp (n, 0);
+          calculateLeftMostReachable (reach, pos_u, indelpos, indellen, parameters.alpha, 1, parameters.piecewise);
+          calculatePenalty (penalty, c, c_snp, pos_u, indelpos, indellen, snppos, snpcount);
+
+          Windows right, windows;
+          if (parameters.symmetric)
+          {
+            std::vector<int> reach_right (n);
+            calculateRightMostReachable (reach_right, pos_u, indelpos, indellen, parameters.alpha, 1, parameters.piecewise);
+            rightWindows (right, reach_right, pos_u);
+          }
+          std::vector<int> start;
+          leftWindowStarts (start, reach, pos_u);
+          constraintWindows (windows, start, right);
+
+          std::vector<bool> R(n, 0);
+          if (parameters.blocks)
+            solveILPBlocks (R, windows, penalty, c, pos_u, parameters.delta, parameters.pos, 1);
+          else
+            solveILP (R, windows, penalty, c, pos_u, parameters.delta, parameters.pos, parameters.threads > 1 ? 1 : 0, parameters.threads > 1); //chromosomes share the cores, one Gurobi thread each
+          long count_variants_retained = 0, count_snp_variants_retained = 0;
+          for (std::size_t i = 0; i < n; i++) if(R[i]) count_variants_retained += c[i], count_snp_variants_retained += c_snp[i];
+          return std::vector<long> {(long) n, (long) indelpos.size() + std::accumulate(snpcount.begin(), snpcount.end(), 0L),
+                                    (long) std::count(R.begin(), R.end(), true), count_variants_retained,
+                                    count_snp_variants_retained, count_variants_retained - count_snp_variants_retained};
+        });
+    return 0;
   }
-}
 
-int main(int argc, char **argv) {
-
-  //parse command line arguments
-  Parameters parameters;
-  parseandSave_ILP(argc, argv, parameters);
+  VCFRegion region (parameters.chr, parameters.region_beg, parameters.region_end);
 
   std::vector<int> indelpos, indellen; 
-  parseVCF_indel (parameters.vcffile, parameters.chr, indelpos, indellen); 
+  parseVCF_indel (parameters.vcffile, region, indelpos, indellen, parameters.threads, parameters.cache);
   assert (indelpos.size() == indellen.size());
   assert (std::is_sorted(indelpos.begin(), indelpos.end())); //must be sorted in ascending order
 
   std::vector<int> snppos, snpcount; 
-  parseVCF_SNP (parameters.vcffile, parameters.chr, snppos, snpcount);
+  parseVCF_SNP (parameters.vcffile, region, snppos, snpcount, parameters.threads, parameters.observed, parameters.cache);
   assert (snppos.size() == snpcount.size());
   assert (std::is_sorted(snppos.begin(), snppos.end())); //must be sorted in ascending order
 
@@ -306,16 +241,67 @@ int main(int argc, char **argv) {
   std::cout<< "INFO, VF::main, count of indels = " << indelpos.size() << "\n";
   std::cout<< "INFO, VF::main, count of SNP variants = " << std::accumulate(snpcount.begin(), snpcount.end(), 0) << "\n";
 
-  // ILP algorithm
-  GRBVar* x = 0;
+  int n = pos_u.size();
+
+  if (parameters.sweep_points.size() > 0)
+  {
+    //compute penalty of variant removal for each position, independent of alpha and delta
+    std::vector<int> c(n, 0), c_snp(n, 0), penalty (n);
+    calculatePenalty (penalty, c, c_snp, pos_u, indelpos, indellen, snppos, snpcount);
 
+    runSweep<Windows> (parameters.sweep_points, parameters.threads,
+        {"positions_retained", "variants_retained", "snp_variants_retained", "indel_variants_retained"},
+        [&](const std::vector<int> &alphas)
+        {
+          std::vector<std::vector<int>> reach, reach_right;
+          calculateLeftMostReachable (reach, pos_u, indelpos, indellen, alphas, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+          if (parameters.symmetric)
+            calculateRightMostReachable (reach_right, pos_u, indelpos, indellen, alphas, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+
+          std::vector<Windows> windows (alphas.size());
+          for (std::size_t a = 0; a < alphas.size(); a++)
+          {
+            Windows right;
+            if (parameters.symmetric) rightWindows (right, reach_right[a], pos_u);
+            std::vector<int> start;
+            leftWindowStarts (start, reach[a], pos_u);
+            constraintWindows (windows[a], start, right);
+          }
+          return windows;
+        },
+        [&](int /*alpha*/, int delta, const Windows &windows)
+        {
+          std::vector<bool> R(n, 0);
+          if (parameters.blocks)
+            solveILPBlocks (R, windows, penalty, c, pos_u, delta, parameters.pos, 1);
+          else
+            solveILP (R, windows, penalty, c, pos_u, delta, parameters.pos, parameters.threads > 1 ? 1 : 0, parameters.threads > 1); //points share the cores, one Gurobi thread each
+          long count_variants_retained = 0, count_snp_variants_retained = 0;
+          for (std::size_t i = 0; i < n; i++) if(R[i]) count_variants_retained += c[i], count_snp_variants_retained += c_snp[i];
+          return std::vector<long> {(long) std::count(R.begin(), R.end(), true), count_variants_retained,
+                                    count_snp_variants_retained, count_variants_retained - count_snp_variants_retained};
+        });
+    return 0;
+  }
+
+  // ILP algorithm
   auto tStart = std::chrono::system_clock::now();
   std::cout<< "INFO, VF::main, starting timer" << "\n";
 
-  int n = pos_u.size();
   //compute reachability
   std::vector<int> reach (n);
-  calculateLeftMostReachable (reach, pos_u, indelpos, indellen, parameters.alpha); 
+  calculateLeftMostReachable (reach, pos_u, indelpos, indellen, parameters.alpha, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+
+  Windows right, windows;
+  if (parameters.symmetric)
+  {
+    std::vector<int> reach_right (n);
+    calculateRightMostReachable (reach_right, pos_u, indelpos, indellen, parameters.alpha, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+    rightWindows (right, reach_right, pos_u);
+  }
+  std::vector<int> start;
+  leftWindowStarts (start, reach, pos_u);
+  constraintWindows (windows, start, right);
 
   //compute penalty of variant removal for each position
   std::vector<bool> R(n, 0);  /* R[i] = true means variant position i is retained*/
@@ -329,84 +315,10 @@ int main(int argc, char **argv) {
   //sum of 'c' values should equal sum of indels and SNPs
   assert (std::accumulate(c.begin(), c.end(), 0) == indelpos.size() + std::accumulate(snpcount.begin(), snpcount.end(), 0));
 
-  try
-  {
-    //Gurobi modeling
-    std::cout<< "INFO, VF::main, Gurobi solver starting" << "\n";
-    GRBEnv* env = 0;
-    env = new GRBEnv();
-    GRBModel model = GRBModel(*env);
-
-    //comment out this line to enable Gurobi output log
-    model.set(GRB_IntParam_LogToConsole, 0);
-
-    // Create variables
-    std::vector<double> zeros (n, 0.0);
-    std::vector<double> ones (n, 1.0);
-    std::vector<char> type (n, GRB_BINARY);
-
-    x = model.addVars(zeros.data(), ones.data(), NULL, type.data(), NULL, n);
-
-    // Set objective
-    GRBLinExpr obj = 0;
-
-    if (parameters.pos)
-      std::cout << "INFO, VF::main, ILP solver will attempt to minimize variant positions" << "\n";
-    else
-      std::cout << "INFO, VF::main, ILP solver will attempt to minimize count of variants " << "\n";
-
-    for (int i = 0; i < n; i++)
-    {
-      if (parameters.pos)
-        obj += 1*x[i];
-      else
-        obj += c[i]*x[i];
-    }
-
-    //maximize c.x
-    model.setObjective(obj, GRB_MAXIMIZE);
-
-    // Add constraints
-    for (int i = 0; i < n; i++)
-    {
-      GRBLinExpr lhs = 0;
-
-      auto leftMostVariantPos_it = std::upper_bound (pos_u.begin(), pos_u.end(), reach[i]);
-      auto leftMostVariantPos_index = leftMostVariantPos_it - pos_u.begin();
-      for (int j = i; j >= leftMostVariantPos_index; j--)
-        lhs += penalty[j] * x[j];
-
-      model.addConstr(lhs , GRB_LESS_EQUAL, 1.0 * parameters.delta);
-      //this adds each contraint row of A.x <= b one by one
-    }
-
-    model.optimize();
-
-    if (model.get(GRB_IntAttr_Status) == GRB_OPTIMAL) {
-      double objval = model.get(GRB_DoubleAttr_ObjVal);
-      std::cout << "Optimal objective: " << objval << std::endl;
-    } 
-
-    // To store variant positions retained
-    for(int i =0; i < n; i++){
-      if(x[i].get(GRB_DoubleAttr_X) < 0.5)
-        R[i] = true;
-    }
-  } 
-  catch (GRBException e) {
-    std::cout << "ERROR, VF::main, Gurobi exception raised, error code = " << e.getErrorCode() << ", ";
-    std::cout << e.getMessage() << std::endl;
-    if (e.getErrorCode() == 10009)
-    {
-      std::cout << "Step1. Get your free Gurobi academic license code by registering here: https://www.gurobi.com/downloads/end-user-license-agreement-academic" << std::endl;
-      std::cout << "Step2. Add your licence key by using build/gurobi910/linux64/bin/grbgetkey tool" << std::endl;
-    }
-    exit(1);
-  } 
-  catch (...) {
-    std::cout << "Error during optimization" << std::endl;
-    exit(1);
-  }
+  if (parameters.blocks)
+    solveILPBlocks (R, windows, penalty, c, pos_u, parameters.delta, parameters.pos, parameters.threads, true);
+  else
+    solveILP (R, windows, penalty, c, pos_u, parameters.delta, parameters.pos);
 
   //end of ILP
    
@@ -423,6 +335,9 @@ int main(int argc, char **argv) {
   std::cout<< "INFO, VF::main, count of SNP variants retained = " << count_snp_variants_retained << "\n";
   std::cout<< "INFO, VF::main, count of indel variants retained = " << count_variants_retained - count_snp_variants_retained << "\n";
 
+  //check all maximal windows in one pass
+  printWindowCheck (R, penalty, windows, parameters.delta);
+
   printVariantGapStats (R, pos_u);
   if (parameters.prefix.length() > 0) print_snp_indel_vcf (R, pos_u, parameters);
   return 0;
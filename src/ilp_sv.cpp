@@ -9,215 +9,202 @@
 #include <chrono>
 #include <numeric>
 #include <cassert>
-#include <unordered_map>
+#include <atomic>
 #include "ext/prettyprint.hpp"
 #include "common.hpp"
+#include "vcf.hpp"
+#include "reach_cache.hpp"
+#include "penalty.hpp"
+#include "window.hpp"
+#include "blocks.hpp"
+#include "sweep.hpp"
+#include "genome.hpp"
 #include "gurobi_c++.h"
 
 /********* Helper functions ******/
 
 /**
- * @brief  parse VCF file to record info of insertion and deletion SVs
+ * @brief   solve ILP to decide variant positions to retain, maximizing the
+ *          count of dropped variants (or positions if pos is set) such that
+ *          penalty of dropped positions within each window stays within delta,
+ *          one constraint row per maximal window. threads limits the Gurobi
+ *          threads (0 leaves the default), quiet suppresses all output
  */
-void parseVCF (const std::string &sv_vcf_file, const std::string &chromosomeId, std::vector<int> &svpos, std::vector<int> &svlen)
+void solveILP (std::vector<bool> &R, const Windows &windows, const std::vector<int> &penalty, const std::vector<int> &c, const std::vector<int> &svpos_u, const int &delta, const bool &pos, int threads = 0, bool quiet = false)
 {
-  std::ifstream file (sv_vcf_file);
-  std::string line;
-  while (std::getline(file, line))
-  {
-    if (line[0] != '#') //ignore beginning header lines 
-    {
-      int column = 0, pos, len;
-      std::string chr, type;
-      for (size_t i = 0; i < line.size() && line[i] != '\0' && line[i] != '\n'; i++) 
-      {
-        if (column == 0 && line[i] != '\t')
-          chr += line[i];
-
-        if (column == 1 && line[i-1] == '\t')
-          pos = std::atoi(&line[i]);
-
-        if (column == 7 && (std::strncmp(&line[i], "SVLEN=", 6) == 0))
-          len = std::abs((int) std::atof(&line[i + 6])); //ignore sign
-
-        if (column == 7 && strncmp(&line[i], "SVTYPE=", 7) == 0) 
-          type = std::string(&line[i + 7]);
-
-        if (line[i] == '\t') 
-          column++; //next column
-      }
-
-      if (chr == chromosomeId)
-      {
-        //only consider INSs and DELs
-        if (std::strncmp(type.c_str(), "INS", 3) == 0) 
-        {
-          svpos.push_back(pos);
-          svlen.push_back(len);
-        }
-        else if (std::strncmp(type.c_str(), "DEL", 3) == 0)
-        {
-          svpos.push_back(pos);
-          svlen.push_back(-1 * len); //negative for deletions
-        }
-      }
-    }
-  }
+  int n = svpos_u.size();
+  GRBVar* x = 0;
 
-  if (svpos.size() == 0 || svlen.size() == 0)
+  try
   {
-    std::cerr << "ERROR, VF::parseVCF, count of SVs found is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
-    exit(1);
-  }
-}
+    //Gurobi modeling
+    if (!quiet) std::cout<< "INFO, VF::solveILP, Gurobi solver starting" << "\n";
+    GRBEnv env (quiet);
+    if (quiet) { env.set(GRB_IntParam_OutputFlag, 0); env.start(); }
+    GRBModel model = GRBModel(env);
 
-/**
- * @brief   compute left-most reachable vertex from each variant position
- *          using up to alpha-1 labeled edges     
- */
-void calculateLeftMostReachable (std::vector<int> &reach, const std::vector<int> &svpos_u, const std::vector<int> &svpos, const std::vector<int> &svlen, const int &alpha)
-{
-  assert(alpha > 2); //the logic below requires this
-  assert (reach.size() == svpos_u.size());
+    //comment out this line to enable Gurobi output log
+    model.set(GRB_IntParam_LogToConsole, 0);
+    if (threads > 0) model.set(GRB_IntParam_Threads, threads);
 
-  /* 1. build edge-labeled graph g */
-  //reminder: vcf file contains 1-based position offsets
-  //suppose x = last position containing variant
-  //then build backbone chain of x+1 vertices
-  int g_edge_count = *(std::max_element(svpos.begin(), svpos.end())); 
-  //std::cout << "INFO, VF::calculateLeftMostReachable, max SV position recorded = " << g_edge_count << "\n";
-  std::vector<int> reach_tmp (g_edge_count+1, 0); //leftmost reachable from all vertices
+    // Create variables
+    std::vector<double> zeros (n, 0.0);
+    std::vector<double> ones (n, 1.0);
+    std::vector<char> type (n, GRB_BINARY);
 
-  //not necessary, but bool vectors may help with faster lookup
-  std::vector<bool> out_edges (g_edge_count+1, 0);
-  std::vector<bool> in_edges (g_edge_count+1, 0);
+    x = model.addVars(zeros.data(), ones.data(), NULL, type.data(), NULL, n);
 
+    // Set objective
+    GRBLinExpr obj = 0;
 
-  //save outgoing neighbors associated with unlabeled deletion edges only
-  std::unordered_map<int,std::vector<int>> g_out_d_neighbors;
-  for (std::size_t i = 0; i < svpos.size(); i++)
-  {
-    if (svlen[i] < 0) //only deletions
+    if (!quiet)
     {
-      //add deletion edge from svpos[i] to svpos[i] + |svlen[i]|
-      int from = svpos[i]; int to = svpos[i] + std::abs(svlen[i]);
-
-      out_edges[from] = true, in_edges[to] = true;
+      if (pos)
+          std::cout << "INFO, VF::solveILP, ILP solver will attempt to minimize variant positions" << "\n";
+      else
+          std::cout << "INFO, VF::solveILP, ILP solver will attempt to minimize count of variants " << "\n";
+    }
 
-      if (g_out_d_neighbors.find(from) != g_out_d_neighbors.end()) //search
-        g_out_d_neighbors[from].push_back(to);   //add 'to'
+    for (int i = 0; i < n; i++)
+    {
+      if (pos)
+        obj += 1*x[i];
       else
-        g_out_d_neighbors[from] = std::vector<int> {to}; //initialize
+        obj += c[i]*x[i];
     }
-  }
 
-  //initialize vector of size alpha - 1
-  //first value signifies vertex reachable using 1 edge, second using 2 edges and so on
-  std::vector<int> currentPos (alpha-1);
-  std::vector<int>  previousPos (alpha-1);
+    //maximize c.x
+    model.setObjective(obj, GRB_MAXIMIZE);
 
-  //each vertex sends update using its out-going (unlabeled) edge
-  //these updates are maintained in a hash table, until the vertex is visited
-  std::unordered_map<int, std::vector<int>> updateAhead;
+    // Add constraints, windows contained in others are implied by them
+    if (!quiet) std::cout << "INFO, VF::solveILP, adding " << windows.size() << " window constraints for " << n << " variant positions" << "\n";
+    for (std::size_t k = 0; k < windows.size(); k++)
+    {
+      GRBLinExpr lhs = 0;
 
-  std::cout << "INFO, VF::calculateLeftMostReachable, computing window ranges...\n" << std::flush;
+      for (int j = windows.end[k]; j >= windows.beg[k]; j--)
+        lhs += penalty[j] * x[j];
 
-  for (std::size_t i = 1; i <= g_edge_count; i++)
-  {
-    if (i == 1) //base case
-    {
-      std::fill (currentPos.begin(), currentPos.end(), 1); //can only reach 1st vertex
+      model.addConstr(lhs , GRB_LESS_EQUAL, 1.0 * delta);
+      //this adds each contraint row of A.x <= b one by one
     }
-    else
-    {
-      //use labeled edge
-      std::memmove(&currentPos[1], &currentPos[0], (alpha-2)*sizeof(int)); //right shift by 1
-      currentPos[0] = i - 1;  // vertex i-1 is reachable using one edge
 
-      //use updates sent via in-coming unlabeled edges
-      if (in_edges[i])
-      {
-        assert (updateAhead.find(i) != updateAhead.end());
+    model.optimize();
 
-        //take pairwise minimum with vector saved at updateAhead[i]
-        std::transform (updateAhead[i].begin(), updateAhead[i].end(),
-            currentPos.begin(), currentPos.begin(), [&](int a, int b){return std::min(a,b);});
+    if (model.get(GRB_IntAttr_Status) == GRB_OPTIMAL && !quiet) {
+      double objval = model.get(GRB_DoubleAttr_ObjVal);
+      std::cout << "Optimal objective: " << objval << std::endl;
+    } 
 
-        updateAhead.erase(i); //no longer needed
-      }
+    // To store variant positions retained
+    for(int i =0; i < n; i++){
+      if(x[i].get(GRB_DoubleAttr_X) < 0.5)
+        R[i] = true;
     }
-
-    //check unlabelled outgoing edges going *out* of vertex position i
-    if (out_edges[i]) //check adjacency list
+    delete[] x;
+  } 
+  catch (GRBException e) {
+    std::cout << "ERROR, VF::solveILP, Gurobi exception raised, error code = " << e.getErrorCode() << ", ";
+    std::cout << e.getMessage() << std::endl;
+    if (e.getErrorCode() == 10009)
     {
-      assert (g_out_d_neighbors.find(i) != g_out_d_neighbors.end());
-
-      for (auto &v: g_out_d_neighbors[i]) //iterate over all out-going vertices
-      {
-        assert (v>i);
-
-        if (updateAhead.find(v) == updateAhead.end())
-          updateAhead[v] = std::vector<int> (alpha-1, v); //initialize
-
-        assert (currentPos.size() == updateAhead[v].size());
-
-        //take pairwise minimum with vector currentPos
-        std::transform (currentPos.begin(), currentPos.end(),
-            updateAhead[v].begin(), updateAhead[v].begin(), [&](int a, int b){return std::min(a,b);});
-      }
+      std::cout << "Step1. Get your free Gurobi academic license code by registering here: https://www.gurobi.com/downloads/end-user-license-agreement-academic" << std::endl;
+      std::cout << "Step2. Add your licence key by using build/gurobi910/linux64/bin/grbgetkey tool" << std::endl;
     }
-
-    reach_tmp[i] = currentPos[alpha-2]; //this is the last value in currentPos vector
+    exit(1);
+  } 
+  catch (...) {
+    std::cout << "Error during optimization" << std::endl;
+    exit(1);
   }
-
-  std::cout << "INFO, VF::calculateLeftMostReachable, done" << std::endl;
-
-  //we need reachability info only for variant positions
-  for (std::size_t i = 0; i < reach.size(); i++)
-    reach[i] = reach_tmp[svpos_u[i]];
 }
 
 /**
- * @brief   Compute penalty associated with dropping variants at each position.
- *          This function also computes c vector along side penalties.
+ * @brief   solveILP on each independent block of windows, see
+ *          independentBlocks. Blocks where dropping all positions satisfies
+ *          every window skip the solver, the others are solved as separate
+ *          smaller models on a pool of threads.
  */
-void calculatePenalty (std::vector<int> &penalty, std::vector<int> &c, const std::vector<int> &svpos_u, const std::vector<int> &svpos, const std::vector<int> &svlen)
+void solveILPBlocks (std::vector<bool> &R, const Windows &windows, const std::vector<int> &penalty, const std::vector<int> &c, const std::vector<int> &svpos_u, const int &delta, const bool &pos, int threads, bool verbose = false)
 {
-  assert(penalty.size() == svpos_u.size());
+  Windows blocks;
+  independentBlocks (blocks, windows, svpos_u.size());
+  if (verbose) printBlocks (blocks);
 
-  int g_edge_count = *(std::max_element(svpos.begin(), svpos.end())); 
-  std::vector<int> max_ins_size (g_edge_count+1, 0);
-  std::vector<int> max_del_size (g_edge_count+1, 0);
-  std::vector<int> count (g_edge_count+1, 0);
-
-  for (std::size_t i = 0; i < svpos.size(); i++)
-  {
-    if (svlen[i] > 0)
-      max_ins_size[svpos[i]] = std::max(max_ins_size[svpos[i]], svlen[i]);
-    else
-      max_del_size[svpos[i]] = std::max(max_del_size[svpos[i]], std::abs(svlen[i]));
-
-    count[svpos[i]]++;
-  }
-
-  for (std::size_t i = 0; i < penalty.size(); i++)
+  std::atomic<int> solved (0);
+  selectBlocks (R, blocks, threads, [&](int beg, int end, std::vector<bool> &R_block)
   {
-    penalty[i] = max_ins_size[svpos_u[i]] + max_del_size[svpos_u[i]];
-    c[i] = count[svpos_u[i]];
-  }
+    Windows windows_block;
+    sliceWindows (windows_block, windows, beg, end);
+    std::vector<int> penalty_block (penalty.begin() + beg, penalty.begin() + end + 1);
+    if (verifyWindows (R_block, penalty_block, windows_block, delta) == 0) return; //drop all
+
+    std::vector<int> c_block (c.begin() + beg, c.begin() + end + 1), pos_block (svpos_u.begin() + beg, svpos_u.begin() + end + 1);
+    solveILP (R_block, windows_block, penalty_block, c_block, pos_block, delta, pos, threads > 1 ? 1 : 0, true);
+    solved++;
+  });
+  if (verbose) std::cout << "INFO, VF::solveILPBlocks, solved " << solved << " blocks with Gurobi, dropped all positions of the others" << "\n";
 }
 
 int main(int argc, char **argv) {
 
   //parse command line arguments
   Parameters parameters;
-  parseandSave_ILP(argc, argv, parameters);
+  parseandSave_ILP(argc, argv, parameters, CLI_WINDOWS, 3); //window ranges require alpha > 2
+
+  if (parameters.genome_wide)
+  {
+    std::vector<ContigVariants> contigs;
+    parseVCF (parameters.vcffile, VCFContigs {parameters.chr_list}, contigs, parameters.threads);
+
+    std::vector<std::string> chrs; std::vector<std::size_t> work;
+    for (auto &v: contigs) chrs.push_back(v.chr), work.push_back(v.pos.size());
+
+    runChromosomes (chrs, work, parameters.threads,
+        {"positions", "variants", "positions_retained", "variants_retained"},
+        [&](std::size_t k)
+        {
+          const std::vector<int> &svpos = contigs[k].pos, &svlen = contigs[k].val;
+          assert (std::is_sorted(svpos.begin(), svpos.end())); //must be sorted in ascending order
+
+          std::vector<int> svpos_u;
+          std::unique_copy(svpos.begin(), svpos.end(), std::back_inserter(svpos_u));
+          int n = svpos_u.size();
+
+          std::vector<int> reach (n), penalty (n), c (n, 0);
+          calculateLeftMostReachable (reach, svpos_u, svpos, svlen, parameters.alpha, 1, parameters.piecewise);
+          calculatePenalty (penalty, c, svpos_u, svpos, svlen);
+
+          Windows right, windows;
+          if (parameters.symmetric)
+          {
+            std::vector<int> reach_right (n);
+            calculateRightMostReachable (reach_right, svpos_u, svpos, svlen, parameters.alpha, 1, parameters.piecewise);
+            rightWindows (right, reach_right, svpos_u);
+          }
+          std::vector<int> start;
+          leftWindowStarts (start, reach, svpos_u);
+          constraintWindows (windows, start, right);
+
+          std::vector<bool> R(n, 0);
+          if (parameters.blocks)
+            solveILPBlocks (R, windows, penalty, c, svpos_u, parameters.delta, parameters.pos, 1);
+          else
+            solveILP (R, windows, penalty, c, svpos_u, parameters.delta, parameters.pos, parameters.threads > 1 ? 1 : 0, parameters.threads > 1); //chromosomes share the cores, one Gurobi thread each
+          long count_variants_retained = 0;
+          for (std::size_t i = 0; i < n; i++) if(R[i]) count_variants_retained += c[i];
+          return std::vector<long> {(long) n, (long) svpos.size(), (long) std::count(R.begin(), R.end(), true), count_variants_retained};
+        });
+    return 0;
+  }
+
+  VCFRegion region (parameters.chr, parameters.region_beg, parameters.region_end);
 
   //*********************************************************
   // Reading from file to store c
 
   std::vector<int> svpos, svlen; 
-  parseVCF (parameters.vcffile, parameters.chr, svpos, svlen); 
+  parseVCF (parameters.vcffile, region, svpos, svlen, parameters.threads, parameters.cache);
   assert (svpos.size() == svlen.size());
   assert (std::is_sorted(svpos.begin(), svpos.end())); //must be sorted in ascending order
   //*********************************************************
@@ -232,98 +219,73 @@ int main(int argc, char **argv) {
   std::cout<< "INFO, VF::main, count of variant containing positions = " << svpos_u.size() << "\n";
   std::cout<< "INFO, VF::main, count of variants = " << svpos.size() << "\n";
 
-  // ILP algorithm
-  GRBVar* x = 0;
+  if (parameters.sweep_points.size() > 0)
+  {
+    //compute penalty of variant removal for each position, independent of alpha and delta
+    std::vector<int> penalty (n);
+    calculatePenalty (penalty, c, svpos_u, svpos, svlen);
+
+    runSweep<Windows> (parameters.sweep_points, parameters.threads,
+        {"positions_retained", "variants_retained"},
+        [&](const std::vector<int> &alphas)
+        {
+          std::vector<std::vector<int>> reach, reach_right;
+          calculateLeftMostReachable (reach, svpos_u, svpos, svlen, alphas, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+          if (parameters.symmetric)
+            calculateRightMostReachable (reach_right, svpos_u, svpos, svlen, alphas, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+
+          std::vector<Windows> windows (alphas.size());
+          for (std::size_t a = 0; a < alphas.size(); a++)
+          {
+            Windows right;
+            if (parameters.symmetric) rightWindows (right, reach_right[a], svpos_u);
+            std::vector<int> start;
+            leftWindowStarts (start, reach[a], svpos_u);
+            constraintWindows (windows[a], start, right);
+          }
+          return windows;
+        },
+        [&](int /*alpha*/, int delta, const Windows &windows)
+        {
+          std::vector<bool> R(n, 0);
+          if (parameters.blocks)
+            solveILPBlocks (R, windows, penalty, c, svpos_u, delta, parameters.pos, 1);
+          else
+            solveILP (R, windows, penalty, c, svpos_u, delta, parameters.pos, parameters.threads > 1 ? 1 : 0, parameters.threads > 1); //points share the cores, one Gurobi thread each
+          long count_variants_retained = 0;
+          for (std::size_t i = 0; i < n; i++) if(R[i]) count_variants_retained += c[i];
+          return std::vector<long> {(long) std::count(R.begin(), R.end(), true), count_variants_retained};
+        });
+    return 0;
+  }
 
+  // ILP algorithm
   auto tStart = std::chrono::system_clock::now();
   std::cout<< "INFO, VF::main, starting timer" << "\n";
 
   //compute reachability
   std::vector<int> reach (n);
-  calculateLeftMostReachable (reach, svpos_u, svpos, svlen, parameters.alpha); 
+  calculateLeftMostReachable (reach, svpos_u, svpos, svlen, parameters.alpha, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+
+  Windows right, windows;
+  if (parameters.symmetric)
+  {
+    std::vector<int> reach_right (n);
+    calculateRightMostReachable (reach_right, svpos_u, svpos, svlen, parameters.alpha, parameters.threads, parameters.piecewise, parameters.vcffile, parameters.cache);
+    rightWindows (right, reach_right, svpos_u);
+  }
+  std::vector<int> start;
+  leftWindowStarts (start, reach, svpos_u);
+  constraintWindows (windows, start, right);
 
   //compute penalty of variant removal for each position
   std::vector<int> penalty (n);
   calculatePenalty (penalty, c, svpos_u, svpos, svlen);
 
-  try
-  {
-    //Gurobi modeling
-    std::cout<< "INFO, VF::main, Gurobi solver starting" << "\n";
-    GRBEnv* env = 0;
-    env = new GRBEnv();
-    GRBModel model = GRBModel(*env);
-
-    //comment out this line to enable Gurobi output log
-    model.set(GRB_IntParam_LogToConsole, 0);
-
-    // Create variables
-    std::vector<double> zeros (n, 0.0);
-    std::vector<double> ones (n, 1.0);
-    std::vector<char> type (n, GRB_BINARY);
-
-    x = model.addVars(zeros.data(), ones.data(), NULL, type.data(), NULL, n);
-
-    // Set objective
-    GRBLinExpr obj = 0;
-
-    if (parameters.pos)
-        std::cout << "INFO, VF::main, ILP solver will attempt to minimize variant positions" << "\n";
-    else
-        std::cout << "INFO, VF::main, ILP solver will attempt to minimize count of variants " << "\n";
-
-    for (int i = 0; i < n; i++)
-    {
-      if (parameters.pos)
-        obj += 1*x[i];
-      else
-        obj += c[i]*x[i];
-    }
-
-    //maximize c.x
-    model.setObjective(obj, GRB_MAXIMIZE);
-
-    // Add constraints
-    for (int i = 0; i < n; i++)
-    {
-      GRBLinExpr lhs = 0;
-
-      auto leftMostVariantPos_it = std::upper_bound (svpos_u.begin(), svpos_u.end(), reach[i]);
-      auto leftMostVariantPos_index = leftMostVariantPos_it - svpos_u.begin();
-      for (int j = i; j >= leftMostVariantPos_index; j--)
-        lhs += penalty[j] * x[j];
-
-      model.addConstr(lhs , GRB_LESS_EQUAL, 1.0 * parameters.delta);
-      //this adds each contraint row of A.x <= b one by one
-    }
-
-    model.optimize();
-
-    if (model.get(GRB_IntAttr_Status) == GRB_OPTIMAL) {
-      double objval = model.get(GRB_DoubleAttr_ObjVal);
-      std::cout << "Optimal objective: " << objval << std::endl;
-    } 
-
-    // To store variant positions retained
-    for(int i =0; i < n; i++){
-      if(x[i].get(GRB_DoubleAttr_X) < 0.5)
-        R[i] = true;
-    }
-  } 
-  catch (GRBException e) {
-    std::cout << "ERROR, VF::main, Gurobi exception raised, error code = " << e.getErrorCode() << ", ";
-    std::cout << e.getMessage() << std::endl;
-    if (e.getErrorCode() == 10009)
-    {
-      std::cout << "Step1. Get your free Gurobi academic license code by registering here: https://www.gurobi.com/downloads/end-user-license-agreement-academic" << std::endl;
-      std::cout << "Step2. Add your licence key by using build/gurobi910/linux64/bin/grbgetkey tool" << std::endl;
-    }
-    exit(1);
-  } 
-  catch (...) {
-    std::cout << "Error during optimization" << std::endl;
-    exit(1);
-  }
+  if (parameters.blocks)
+    solveILPBlocks (R, windows, penalty, c, svpos_u, parameters.delta, parameters.pos, parameters.threads, true);
+  else
+    solveILP (R, windows, penalty, c, svpos_u, parameters.delta, parameters.pos);
 
   std::chrono::duration<double> wctduration = (std::chrono::system_clock::now() - tStart);
   std::cout<< "INFO, VF::main, time taken by variant selection algorithm = " << wctduration.count() << " seconds" << "\n"; 
@@ -333,6 +295,10 @@ int main(int argc, char **argv) {
   int count_variants_retained=0;
   for (std::size_t i = 0; i < n; i++) if(R[i]) count_variants_retained += c[i]; 
   std::cout<< "INFO, VF::main, count of variants retained = " << count_variants_retained << "\n";
+
+  //check all maximal windows in one pass
+  printWindowCheck (R, penalty, windows, parameters.delta);
+
   printVariantGapStats (R, svpos_u);
   if (parameters.prefix.length() > 0) print_SV_vcf (R, svpos_u, parameters);
 
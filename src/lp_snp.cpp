@@ -10,85 +10,33 @@
 #include <cstdlib>
 #include <random>
 #include "common.hpp"
+#include "vcf.hpp"
+#include "sweep.hpp"
+#include "genome.hpp"
 #include "gurobi_c++.h"
 
-int main(int argc, char **argv) {
-
-  //parse command line arguments
-  Parameters parameters;
-  parseandSave(argc, argv, parameters);
-
-  //*********************************************************
-  // Extract SNPs and allele count from VCF
-  // seed random generator by time in seconds (this may create issue if two instances are launched at the same time)
-  srand(time(0)); int random = rand() % 100000;  
-  std::string tmp_file = ".VF." + std::to_string(random) + ".txt";
-  std::string cmd = std::string(TOSTRING(VCFTOOLSPATH)) + " --vcf " + parameters.vcffile + " --chr " + parameters.chr + " --counts --remove-indels --out " + tmp_file + " 2>/dev/null";
-  std::cout << "INFO, VF::main, extracting SNPs from vcf file using command = " << cmd << std::endl;
-  std::system(cmd.c_str());
-  std::cout << "INFO, VF::main, vcftools finished" << std::endl;
-
-  //*********************************************************
-  // Reading from temp file to store c
-
-  std::ifstream file(tmp_file + ".frq.count");
-  std::vector<int> p, c; 
-  std::string line;
-
-  while (std::getline(file, line))
-  {
-    std::string col1;
-    int col2, col3;
-
-    std::istringstream iss(line);
-    iss >> col1;
-    if (col1.compare("CHROM") != 0)  //ignore the first header line
-    {
-      iss >> col2 >> col3;
-      p.push_back(col2);
-      c.push_back(col3 - 1);
-    }
-  }
-
-  //keep only one record per loci
-  ignoreDuplicateSNPrecords(p, c);
-  assert (std::is_sorted(p.begin(), p.end()));
-
-  cmd = "rm -f " + tmp_file + "*";
-  std::system(cmd.c_str()); //delete tmp file
-  if (p.size() == 0)
-  {
-    std::cerr << "ERROR, VF::main, count of variants is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
-    exit(1);
-  }
-  //*********************************************************
-
-  std::cout<< "INFO, VF::main, count of variant containing positions = " << p.size() << "\n";
-  std::cout<< "INFO, VF::main, count of variants = " << std::accumulate(c.begin(), c.end(), 0) << "\n";
-
+/**
+ * @brief   solve LP to decide SNP positions to retain, maximizing the count
+ *          of dropped SNPs such that at most delta positions are dropped
+ *          within each alpha-long window. threads limits the Gurobi threads
+ *          (0 leaves the default), quiet suppresses all output
+ */
+void solveLP (std::vector<bool> &R, const std::vector<int> &p, const std::vector<int> &c, const int &alpha, const int &delta, int threads = 0, bool quiet = false)
+{
   int n = p.size();
-
-  // To track retained positions 
-  std::vector<int> new_c;
-
-  //*********************************************************
-  std::vector<bool> R(n, 0);  /* R[i] = true means variant position i is retained*/ 
   GRBVar* x = 0;
 
-  // Lp algorithm using Gurobi
-  auto tStart = std::chrono::system_clock::now();
-  std::cout<< "INFO, VF::main, starting timer" << "\n";
-
   try
   {
     //Gurobi modeling
-    std::cout<< "INFO, VF::main, Gurobi solver starting" << "\n";
-    GRBEnv* env = 0;
-    env = new GRBEnv();
-    GRBModel model = GRBModel(*env);
+    if (!quiet) std::cout<< "INFO, VF::solveLP, Gurobi solver starting" << "\n";
+    GRBEnv env (quiet);
+    if (quiet) { env.set(GRB_IntParam_OutputFlag, 0); env.start(); }
+    GRBModel model = GRBModel(env);
 
     //comment out this line to enable Gurobi output log
     model.set(GRB_IntParam_LogToConsole, 0);
+    if (threads > 0) model.set(GRB_IntParam_Threads, threads);
 
     // Create variables
     std::vector<double> zeros (n, 0.0);
@@ -112,16 +60,16 @@ int main(int argc, char **argv) {
     for (int i = 0; i < n; i++)
     {
       GRBLinExpr lhs = 0;
-      for (int j = i; j >= 0 && p[i]-p[j] < parameters.alpha; j--)
+      for (int j = i; j >= 0 && p[i]-p[j] < alpha; j--)
         lhs += x[j];
 
-      model.addConstr(lhs , GRB_LESS_EQUAL, 1.0 * parameters.delta);
+      model.addConstr(lhs , GRB_LESS_EQUAL, 1.0 * delta);
       //this adds each contraint row of A.x <= b one by one
     }
 
     model.optimize();
 
-    if (model.get(GRB_IntAttr_Status) == GRB_OPTIMAL) {
+    if (model.get(GRB_IntAttr_Status) == GRB_OPTIMAL && !quiet) {
       double objval = model.get(GRB_DoubleAttr_ObjVal);
       std::cout << "Optimal objective: " << objval << std::endl;
     } 
@@ -131,9 +79,10 @@ int main(int argc, char **argv) {
       if(x[i].get(GRB_DoubleAttr_X) < 0.5)
         R[i] = true;
     }
+    delete[] x;
   } 
   catch (GRBException e) {
-    std::cout << "ERROR, VF::main, Gurobi exception raised, error code = " << e.getErrorCode() << ", ";
+    std::cout << "ERROR, VF::solveLP, Gurobi exception raised, error code = " << e.getErrorCode() << ", ";
     std::cout << e.getMessage() << std::endl;
     if (e.getErrorCode() == 10009)
     {
@@ -146,6 +95,79 @@ int main(int argc, char **argv) {
     std::cout << "Error during optimization" << std::endl;
     exit(1);
   }
+}
+
+int main(int argc, char **argv) {
+
+  //parse command line arguments
+  Parameters parameters;
+  parseandSave(argc, argv, parameters, CLI_AC);
+
+  if (parameters.genome_wide)
+  {
+    std::vector<ContigVariants> contigs;
+    parseVCF_SNP (parameters.vcffile, VCFContigs {parameters.chr_list}, contigs, parameters.threads, parameters.observed);
+
+    std::vector<std::string> chrs; std::vector<std::size_t> work;
+    for (auto &v: contigs) chrs.push_back(v.chr), work.push_back(v.pos.size());
+
+    runChromosomes (chrs, work, parameters.threads,
+        {"positions", "variants", "positions_retained", "variants_retained"},
+        [&](std::size_t k)
+        {
+          const std::vector<int> &p = contigs[k].pos, &c = contigs[k].val;
+          std::vector<bool> R(p.size(), 0);
+          solveLP (R, p, c, parameters.alpha, parameters.delta, parameters.threads > 1 ? 1 : 0, parameters.threads > 1); //chromosomes share the cores, one Gurobi thread each
+          long count_variants_retained = 0;
+          for (std::size_t i = 0; i < p.size(); i++) if (R[i]) count_variants_retained += c[i];
+          return std::vector<long> {(long) p.size(), std::accumulate(c.begin(), c.end(), 0L),
+                                    (long) std::count(R.begin(), R.end(), true), count_variants_retained};
+        });
+    return 0;
+  }
+
+  VCFRegion region (parameters.chr, parameters.region_beg, parameters.region_end);
+
+  //*********************************************************
+  // Extract SNPs and allele count from VCF
+
+  std::vector<int> p, c; 
+  parseVCF_SNP (parameters.vcffile, region, p, c, parameters.threads, parameters.observed, parameters.cache);
+  assert (p.size() == c.size());
+  //*********************************************************
+
+  std::cout<< "INFO, VF::main, count of variant containing positions = " << p.size() << "\n";
+  std::cout<< "INFO, VF::main, count of variants = " << std::accumulate(c.begin(), c.end(), 0) << "\n";
+
+  int n = p.size();
+
+  if (parameters.sweep_points.size() > 0)
+  {
+    runSweep<int> (parameters.sweep_points, parameters.threads,
+        {"positions_retained", "variants_retained"},
+        [](const std::vector<int> &alphas) { return std::vector<int> (alphas.size()); },  //nothing to precompute per alpha
+        [&](int alpha, int delta, int)
+        {
+          std::vector<bool> R(n, 0);
+          solveLP (R, p, c, alpha, delta, parameters.threads > 1 ? 1 : 0, parameters.threads > 1); //points share the cores, one Gurobi thread each
+          long count_variants_retained = 0;
+          for (int i = 0; i < n; i++) if (R[i]) count_variants_retained += c[i];
+          return std::vector<long> {(long) std::count(R.begin(), R.end(), true), count_variants_retained};
+        });
+    return 0;
+  }
+
+  // To track retained positions 
+  std::vector<int> new_c;
+
+  //*********************************************************
+  std::vector<bool> R(n, 0);  /* R[i] = true means variant position i is retained*/ 
+
+  // Lp algorithm using Gurobi
+  auto tStart = std::chrono::system_clock::now();
+  std::cout<< "INFO, VF::main, starting timer" << "\n";
+
+  solveLP (R, p, c, parameters.alpha, parameters.delta);
 
   // End of LP
   std::chrono::duration<double> wctduration = (std::chrono::system_clock::now() - tStart);
@@ -160,7 +182,5 @@ int main(int argc, char **argv) {
   printVariantGapStats (R, p);
   if (parameters.prefix.length() > 0) print_snp_vcf(R, p, parameters);
 
-  //clear memory
-  delete[] x;
   return 0;
 }
@@ -0,0 +1,96 @@
+#ifndef VF_PENALTY_HPP
+#define VF_PENALTY_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cassert>
+
+/********* Penalty of dropping the variants at each variant position ******/
+
+/**
+ * @brief   Compute penalty associated with dropping SVs at each position.
+ *          This function also computes c vector along side penalties.
+ */
+void calculatePenalty (std::vector<int> &penalty, std::vector<int> &c, const std::vector<int> &svpos_u, const std::vector<int> &svpos, const std::vector<int> &svlen)
+{
+  assert(penalty.size() == svpos_u.size());
+
+  //svpos is sorted, variants at svpos_u[i] are the next run of svpos
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < penalty.size(); i++)
+  {
+    int max_ins_size = 0, max_del_size = 0, count = 0;
+
+    for (; k < svpos.size() && svpos[k] == svpos_u[i]; k++)
+    {
+      if (svlen[k] > 0)
+        max_ins_size = std::max(max_ins_size, svlen[k]);
+      else
+        max_del_size = std::max(max_del_size, std::abs(svlen[k]));
+
+      count++;
+    }
+
+    penalty[i] = max_ins_size + max_del_size;
+    c[i] = count;
+  }
+  assert (k == svpos.size());
+}
+
+/**
+ * @brief   Compute penalty associated with dropping indels and SNPs at each
+ *          position. This function also computes c and c_snp vectors along
+ *          side penalties.
+ */
+void calculatePenalty (std::vector<int> &penalty, std::vector<int> &c, std::vector<int> &c_snp, const std::vector<int> &pos_u, const std::vector<int> &indelpos, const std::vector<int> &indellen, const std::vector<int> &snppos, const std::vector<int> &snpcount)
+{
+  assert(penalty.size() == pos_u.size());
+
+  //indelpos and snppos are sorted, variants at pos_u[i] are the next runs of both
+  std::size_t k = 0, l = 0;
+  for (std::size_t i = 0; i < penalty.size(); i++)
+  {
+    int max_ins_size = 0, max_del_size = 0, count = 0, count_snp = 0;
+    bool snp_present = false;
+
+    for (; k < indelpos.size() && indelpos[k] == pos_u[i]; k++)
+    {
+      if (indellen[k] > 0)
+        max_ins_size = std::max(max_ins_size, indellen[k]);
+      else
+        max_del_size = std::max(max_del_size, std::abs(indellen[k]));
+      count++;
+    }
+
+    for (; l < snppos.size() && snppos[l] == pos_u[i]; l++)
+    {
+      snp_present = true;
+      count += snpcount[l];
+      count_snp += snpcount[l];
+    }
+
+    if (max_del_size > 0)
+    {
+      //deletion penalty subsumes SNP penalty
+      penalty[i] = max_ins_size + max_del_size;
+    }
+    else
+    {
+      if (snp_present == true)
+        penalty[i] = max_ins_size + 1;
+      else
+        penalty[i] = max_ins_size;
+    }
+
+    c[i] = count;
+    c_snp[i] = count_snp;
+
+    assert (penalty[i] > 0);
+    assert (c[i] > 0);
+    if (snp_present) assert (c_snp[i] > 0);
+  }
+  assert (k == indelpos.size() && l == snppos.size());
+}
+
+#endif
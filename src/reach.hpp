@@ -0,0 +1,707 @@
+#ifndef VF_REACH_HPP
+#define VF_REACH_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <climits>
+#include <map>
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+/********* Reachability in the variation graph ******/
+
+/*
+ * The graph is a backbone chain of vertices 1..x (x = last variant position)
+ * with labeled edges i-1 -> i, plus an unlabeled edge from -> from+|len| per
+ * deletion. currentPos[k] holds the left-most vertex that reaches vertex i
+ * using up to k+1 labeled edges.
+ *
+ * Stepping from vertex i-1 to i without deletion edges shifts currentPos
+ * right by one and puts i-1 in front, so after k such steps from vertex b
+ *
+ *   currentPos_i[j] = i-1-j              for j < k
+ *                   = currentPos_b[j-k]  otherwise
+ *
+ * The sweep therefore materializes currentPos only at deletion endpoints and
+ * evaluates the last entry at variant positions in closed form. currentPos is
+ * kept as a circular buffer, entry j is stored at (head + j) mod (alpha-1),
+ * so a shift by k moves head and writes the k new entries only.
+ *
+ * Alternatively, currentPos and pending updates are stored as lists of linear
+ * pieces. Entries decrease by one per index (shifted-in backbone vertices) or
+ * are constant (vertex 1, initial updates), and min-merges of such lines only
+ * split them where they cross. Shifts and merges then cost O(pieces) rather
+ * than O(alpha).
+ */
+
+/**
+ * @brief   pool of int blocks of fixed size, allocated in slabs; released
+ *          blocks are reused so that a sweep does not call malloc/free
+ *          per deletion edge
+ */
+class UpdatePool
+{
+  public:
+
+    UpdatePool (int block_size) : m(block_size) {}
+
+    int* acquire ()
+    {
+      if (free_blocks.empty())
+      {
+        slabs.emplace_back(new int[(std::size_t) m * SLAB_BLOCKS]);
+        for (int j = SLAB_BLOCKS - 1; j >= 0; j--) free_blocks.push_back(slabs.back().get() + (std::size_t) j * m);
+      }
+      int *b = free_blocks.back();
+      free_blocks.pop_back();
+      return b;
+    }
+
+    void release (int *b) { free_blocks.push_back(b); }
+
+  private:
+
+    static const int SLAB_BLOCKS = 16;
+
+    int m;
+    std::vector<std::unique_ptr<int[]>> slabs;
+    std::vector<int*> free_blocks;
+};
+
+/**
+ * @brief   deletion edges of the graph in sweep order
+ */
+struct DeletionGraph
+{
+  std::vector<int> targets;     //targets of deletion edges, sorted and unique
+  std::vector<int> sources;     //sources of deletion edges, sorted and unique
+  std::vector<int> adj_offset;  //sources[s] -> targets[adj[adj_offset[s] .. adj_offset[s+1]-1]]
+  std::vector<int> adj;
+  std::vector<int> events;      //union of sources and targets, where currentPos must be materialized
+
+  /**
+   * @brief  collect deletion edges from -> from+|len| of the variants with
+   *         negative length, ignoring those leaving vertices 1..x
+   */
+  DeletionGraph (const std::vector<int> &varpos, const std::vector<int> &varlen, int x)
+  {
+    //deletion edges (from, to), sorted by source
+    std::vector<std::pair<int,int>> g_d_edges;
+
+    for (std::size_t i = 0; i < varpos.size(); i++)
+    {
+      if (varlen[i] < 0) //only deletions
+      {
+        //add deletion edge from varpos[i] to varpos[i] + |varlen[i]|
+        int from = varpos[i]; int to = varpos[i] + std::abs(varlen[i]);
+        if (to > x || from < 1) continue; //outside backbone, never visited
+        g_d_edges.emplace_back(from, to);
+      }
+    }
+    std::sort (g_d_edges.begin(), g_d_edges.end());
+
+    for (auto &e: g_d_edges) targets.push_back(e.second);
+    std::sort (targets.begin(), targets.end());
+    targets.erase (std::unique(targets.begin(), targets.end()), targets.end());
+
+    //save outgoing neighbors in compressed sparse row form
+    for (auto &e: g_d_edges)
+    {
+      if (sources.empty() || sources.back() != e.first)
+      {
+        sources.push_back(e.first);
+        adj_offset.push_back(adj.size());
+      }
+      adj.push_back(std::lower_bound(targets.begin(), targets.end(), e.second) - targets.begin());
+    }
+    adj_offset.push_back(adj.size());
+
+    std::set_union (sources.begin(), sources.end(), targets.begin(), targets.end(), std::back_inserter(events));
+  }
+};
+
+/**
+ * @brief   currentPos as a dense circular buffer of alpha-1 ints, pending
+ *          updates are blocks of a slab pool
+ */
+class DenseDistances
+{
+  public:
+
+    typedef int* Update;
+
+    DenseDistances (int block_size) : m(block_size), currentPos(block_size, 1), head(0), pool(block_size) {}
+
+    //base case: vertex 1 can only reach itself
+    void reset () { std::fill (currentPos.begin(), currentPos.end(), 1); head = 0; }
+
+    //shift right by k <= alpha-1, vertex i-1-j is reachable using j+1 edges for j < k
+    void shift (int k, int i)
+    {
+      head = (head + m - k) % m;
+      for (int j = 0; j < k; j++) currentPos[(head + j) % m] = i - 1 - j;
+    }
+
+    int get (int j) const { return currentPos[(head + j) % m]; }
+
+    Update newUpdate (int v) { int *u = pool.acquire(); std::fill (u, u + m, v); return u; }
+    Update copyUpdate (Update src) { int *u = pool.acquire(); std::copy (src, src + m, u); return u; }
+    void release (Update u) { pool.release(u); }
+
+    //u = min(u, src)
+    void combine (Update u, Update src) { minMerge (u, src, m); }
+
+    //take pairwise minimum of currentPos and u in logical order,
+    //saving the result to currentPos (mergeFrom) or to u (mergeInto)
+    void mergeFrom (Update u)
+    {
+      int n1 = m - head; //entries 0..n1-1 are stored from head to the end of buffer
+      minMerge (currentPos.data() + head, u, n1);
+      minMerge (currentPos.data(), u + n1, head);
+    }
+
+    void mergeInto (Update u)
+    {
+      int n1 = m - head;
+      minMerge (u, currentPos.data() + head, n1);
+      minMerge (u + n1, currentPos.data(), head);
+    }
+
+  private:
+
+    int m;
+    std::vector<int> currentPos;
+    int head; //physical index of currentPos entry 0
+    UpdatePool pool;
+};
+
+/**
+ * @brief   linear piece of a distance vector, entries [j, start of next
+ *          piece) take values v + slope * (j' - j)
+ */
+struct LinearPiece
+{
+  int j, v, slope;
+};
+
+typedef std::vector<LinearPiece> PiecewiseLine;
+
+/**
+ * @brief   currentPos and pending updates as lists of linear pieces
+ *          covering entries [0, alpha-1)
+ */
+class PiecewiseDistances
+{
+  public:
+
+    typedef PiecewiseLine* Update;
+
+    PiecewiseDistances (int block_size) : m(block_size) { reset(); }
+
+    //base case: vertex 1 can only reach itself
+    void reset () { currentPos.assign (1, LinearPiece {0, 1, 0}); }
+
+    //shift right by k <= alpha-1, vertex i-1-j is reachable using j+1 edges for j < k
+    void shift (int k, int i)
+    {
+      if (k == 0) return; //pieces keep strictly increasing j
+      tmp.assign (1, LinearPiece {0, i - 1, -1});
+      for (auto &p: currentPos)
+      {
+        if (p.j + k >= m) break;
+        append (tmp, LinearPiece {p.j + k, p.v, p.slope});
+      }
+      currentPos.swap(tmp);
+    }
+
+    int get (int j) const
+    {
+      auto p = std::upper_bound (currentPos.begin(), currentPos.end(), j, [](int j, const LinearPiece &p) { return j < p.j; }) - 1;
+      return p->v + p->slope * (j - p->j);
+    }
+
+    Update newUpdate (int v) { PiecewiseLine *u = acquire(); u->assign (1, LinearPiece {0, v, 0}); return u; }
+    Update copyUpdate (Update src) { PiecewiseLine *u = acquire(); *u = *src; return u; }
+    void release (Update u) { free_lines.push_back(u); }
+
+    //u = min(u, src)
+    void combine (Update u, Update src) { minLines (*u, *src, tmp); u->swap(tmp); }
+
+    void mergeFrom (Update u) { minLines (currentPos, *u, tmp); currentPos.swap(tmp); }
+    void mergeInto (Update u) { minLines (currentPos, *u, tmp); u->swap(tmp); }
+
+  private:
+
+    int m;
+    PiecewiseLine currentPos, tmp;
+    std::vector<std::unique_ptr<PiecewiseLine>> lines;
+    std::vector<PiecewiseLine*> free_lines;
+
+    PiecewiseLine* acquire ()
+    {
+      if (free_lines.empty())
+      {
+        lines.emplace_back(new PiecewiseLine());
+        return lines.back().get();
+      }
+      PiecewiseLine *u = free_lines.back();
+      free_lines.pop_back();
+      return u;
+    }
+
+    //append piece p, extending the last piece if p continues its line
+    static void append (PiecewiseLine &out, const LinearPiece &p)
+    {
+      if (!out.empty())
+      {
+        const LinearPiece &l = out.back();
+        if (l.slope == p.slope && l.v + l.slope * (p.j - l.j) == p.v) return;
+      }
+      out.push_back(p);
+    }
+
+    //out = pairwise minimum of lines a and b
+    void minLines (const PiecewiseLine &a, const PiecewiseLine &b, PiecewiseLine &out) const
+    {
+      out.clear();
+      std::size_t ia = 0, ib = 0;
+      for (int lo = 0; lo < m; )
+      {
+        int end_a = (ia + 1 < a.size()) ? a[ia+1].j : m;
+        int end_b = (ib + 1 < b.size()) ? b[ib+1].j : m;
+        int hi = std::min(end_a, end_b);
+
+        //both lines are linear on [lo, hi), compare them at its ends
+        int sa = a[ia].slope, sb = b[ib].slope;
+        long a0 = a[ia].v + (long) sa * (lo - a[ia].j), b0 = b[ib].v + (long) sb * (lo - b[ib].j);
+        long d0 = a0 - b0, ds = sa - sb, d1 = d0 + ds * (hi - 1 - lo);
+
+        if (d0 <= 0 && d1 <= 0) append (out, LinearPiece {lo, (int) a0, sa});
+        else if (d0 >= 0 && d1 >= 0) append (out, LinearPiece {lo, (int) b0, sb});
+        else if (d0 < 0) //a is smaller up to the crossing, b afterwards
+        {
+          long t = (-d0) / ds + 1;
+          append (out, LinearPiece {lo, (int) a0, sa});
+          append (out, LinearPiece {(int) (lo + t), (int) (b0 + sb * t), sb});
+        }
+        else //b is smaller up to the crossing, a afterwards
+        {
+          long t = d0 / (-ds) + 1;
+          append (out, LinearPiece {lo, (int) b0, sb});
+          append (out, LinearPiece {(int) (lo + t), (int) (a0 + sa * t), sa});
+        }
+
+        lo = hi;
+        if (hi == end_a) ia++;
+        if (hi == end_b) ib++;
+      }
+    }
+};
+
+/**
+ * @brief   sweep over events [e_lo, e_hi) of g, answering reach of variant
+ *          positions [q_lo, q_hi) for each of alphas, alpha is the largest.
+ *          Entries of currentPos do not depend on later ones, so reach for a
+ *          smaller alpha' is read from entry alpha'-2. The segment must start at the first event
+ *          or at least alpha-1 bases after the previous event, so that the
+ *          shift to its first event overwrites currentPos entirely.
+ *          updateAhead[t] holds the pending update of target t, targets
+ *          [t_lo, t_hi) belong to this segment and may come pre-filled with
+ *          updates from earlier segments. Updates to later targets are
+ *          returned in outgoing, as (target, update) pairs.
+ */
+template <typename Distances>
+void sweepReachSegment (const DeletionGraph &g, const std::vector<int> &pos_u, const std::vector<int> &alphas, int alpha,
+    std::size_t e_lo, std::size_t e_hi, std::size_t q_lo, std::size_t q_hi, std::size_t t_lo, std::size_t t_hi,
+    std::vector<std::vector<int>> &reach, Distances &currentPos, std::vector<typename Distances::Update> &updateAhead,
+    std::vector<std::pair<int, typename Distances::Update>> &outgoing)
+{
+  typedef typename Distances::Update Update;
+
+  //vector of size alpha - 1
+  //first value signifies vertex reachable using 1 edge, second using 2 edges and so on
+  const int m = alpha-1;
+  currentPos.reset();
+  int b = (e_lo == 0) ? 1 : g.events[e_lo-1]; //vertex currentPos was last materialized at
+  assert (e_lo == 0 || e_lo == e_hi || g.events[e_lo] - b >= m);
+
+  //value of entry alpha'-2 of currentPos at variant position q, for each alpha'
+  auto answer = [&](std::size_t q)
+  {
+    int i = pos_u[q], k = i - b; //i >= b
+    for (std::size_t a = 0; a < alphas.size(); a++)
+    {
+      int j = alphas[a] - 2;
+      reach[a][q] = (k > j) ? i - 1 - j : currentPos.get(j-k);
+    }
+  };
+
+  //pending update of a target after this segment
+  auto outgoingUpdate = [&](int t) -> Update&
+  {
+    for (auto &o: outgoing) if (o.first == t) return o.second;
+    outgoing.emplace_back(t, (Update) NULL);
+    return outgoing.back().second;
+  };
+
+  //next source and target vertex to visit
+  std::size_t s_next = std::lower_bound(g.sources.begin(), g.sources.end(), e_lo < e_hi ? g.events[e_lo] : INT_MAX) - g.sources.begin();
+  std::size_t t_next = t_lo;
+  std::size_t q = q_lo; //next variant position to answer
+
+  for (std::size_t e = e_lo; e < e_hi; e++)
+  {
+    int i = g.events[e];
+
+    //variant positions before this event lie on plain backbone
+    for (; q < q_hi && pos_u[q] < i; q++)
+      answer(q);
+
+    //use labeled edges b -> ... -> i
+    currentPos.shift (std::min(i - b, m), i);
+    b = i;
+
+    //use updates sent via in-coming unlabeled edges
+    if (t_next < t_hi && g.targets[t_next] == i)
+    {
+      //absent only if all sources lie in earlier segments, not swept yet
+      if (updateAhead[t_next] != NULL)
+      {
+        //take pairwise minimum with vector saved at updateAhead
+        currentPos.mergeFrom (updateAhead[t_next]);
+
+        currentPos.release (updateAhead[t_next]); //no longer needed
+        updateAhead[t_next] = NULL;
+      }
+      t_next++;
+    }
+
+    //check unlabelled outgoing edges going *out* of vertex position i
+    if (s_next < g.sources.size() && g.sources[s_next] == i) //check adjacency list
+    {
+      for (int a = g.adj_offset[s_next]; a < g.adj_offset[s_next+1]; a++) //iterate over all out-going vertices
+      {
+        int t = g.adj[a];
+        assert (g.targets[t] > i);
+
+        Update &u = (t < (int) t_hi) ? updateAhead[t] : outgoingUpdate(t);
+        if (u == NULL) u = currentPos.newUpdate(g.targets[t]); //initialize
+
+        //take pairwise minimum with vector currentPos
+        currentPos.mergeInto (u);
+      }
+      s_next++;
+    }
+  }
+
+  for (; q < q_hi; q++)
+    answer(q);
+}
+
+/**
+ * @brief   compute left-most reachable vertex from each variant position
+ *          using up to alpha-1 labeled edges for each alpha of alphas, see
+ *          calculateLeftMostReachable. All are answered by a single sweep for
+ *          the largest alpha. With threads > 1, the sweep is cut into segments at gaps of at
+ *          least alpha-1 bases between events, which are swept concurrently.
+ *          Deletions spanning a cut are accounted for by a stitching pass
+ *          that re-sweeps, in order, each segment receiving updates from
+ *          earlier segments.
+ */
+template <typename Distances>
+void calculateLeftMostReachable_ (std::vector<std::vector<int>> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const std::vector<int> &alphas, int threads)
+{
+  typedef typename Distances::Update Update;
+
+  assert (alphas.size() > 0);
+  assert (*std::min_element(alphas.begin(), alphas.end()) > 2); //the logic below requires this
+  assert (std::is_sorted(pos_u.begin(), pos_u.end()));
+
+  const int alpha = *std::max_element(alphas.begin(), alphas.end());
+  reach.assign (alphas.size(), std::vector<int> (pos_u.size()));
+
+  /* 1. build edge-labeled graph g */
+  //reminder: vcf file contains 1-based position offsets
+  //suppose x = last position containing variant
+  //then build backbone chain of x+1 vertices
+  //storage below scales with the count of variants, not with x
+  DeletionGraph g (varpos, varlen, pos_u.back());
+  const int m = alpha-1;
+
+  std::cout << "INFO, VF::calculateLeftMostReachable, computing window ranges...\n" << std::flush;
+
+  /* 2. cut events into segments of similar size, preferring cuts no deletion spans */
+  const std::size_t MIN_SEGMENT_EVENTS = 1024; //not worth a thread below this
+  std::vector<std::size_t> cut (1, 0);
+  if (threads > 1 && g.events.size() >= 2 * MIN_SEGMENT_EVENTS)
+  {
+    std::size_t n_e = g.events.size();
+    std::size_t segments = std::min<std::size_t>(threads, n_e / MIN_SEGMENT_EVENTS);
+
+    //furthest target of deletions starting before each event
+    std::vector<int> span (n_e);
+    int furthest = 0;
+    for (std::size_t e = 0, s = 0; e < n_e; e++)
+    {
+      for (; s < g.sources.size() && g.sources[s] < g.events[e]; s++)
+        furthest = std::max(furthest, g.targets[g.adj[g.adj_offset[s+1] - 1]]); //adjacency is sorted
+      span[e] = furthest;
+    }
+
+    for (std::size_t k = 1; k < segments; k++)
+    {
+      std::size_t best = 0;
+      for (std::size_t e = std::max(n_e * k / segments, cut.back() + 1); e < n_e * (k+1) / segments; e++)
+        if (g.events[e] - g.events[e-1] >= m)
+        {
+          if (span[e] < g.events[e]) { best = e; break; } //clean cut
+          if (best == 0) best = e;
+        }
+      if (best > 0) cut.push_back(best);
+    }
+  }
+  cut.push_back(g.events.size());
+  std::size_t segments = cut.size() - 1;
+
+  //each segment owns the variant positions and targets from its first event on
+  auto firstAt = [&](const std::vector<int> &v, std::size_t s)
+  {
+    if (s == 0) return (std::size_t) 0;
+    if (s == segments) return v.size();
+    return (std::size_t) (std::lower_bound(v.begin(), v.end(), g.events[cut[s]]) - v.begin());
+  };
+
+  std::vector<Update> updateAhead (g.targets.size(), NULL); //pending update of each target
+  std::vector<std::vector<std::pair<int, Update>>> outgoing (segments);
+  std::vector<Distances> currentPos; //sweep state of each segment
+  for (std::size_t s = 0; s < segments; s++) currentPos.emplace_back(m);
+
+  auto sweep = [&](std::size_t s)
+  {
+    for (auto &o: outgoing[s]) currentPos[s].release(o.second);
+    outgoing[s].clear();
+    sweepReachSegment (g, pos_u, alphas, alpha, cut[s], cut[s+1], firstAt(pos_u, s), firstAt(pos_u, s+1),
+        firstAt(g.targets, s), firstAt(g.targets, s+1), reach, currentPos[s], updateAhead, outgoing[s]);
+  };
+
+  if (segments == 1)
+  {
+    sweep (0);
+  }
+  else
+  {
+    /* 3. sweep all segments assuming no updates from earlier segments */
+    {
+      ThreadPool pool (threads);
+      for (std::size_t s = 0; s < segments; s++) pool.submit([&, s]{ sweep (s); });
+      pool.wait();
+    }
+
+    /* 4. stitch, re-sweep segments receiving updates over a cut */
+    std::size_t resweeps = 0;
+    for (std::size_t s = 1; s < segments; s++)
+    {
+      std::size_t t_lo = firstAt(g.targets, s), t_hi = firstAt(g.targets, s+1);
+      bool incoming = false;
+      for (std::size_t r = 0; r < s; r++)
+        for (auto &o: outgoing[r])
+          if (o.first >= (int) t_lo && o.first < (int) t_hi)
+          {
+            Update &u = updateAhead[o.first];
+            if (u == NULL) u = currentPos[s].copyUpdate(o.second);
+            else currentPos[s].combine(u, o.second);
+            incoming = true;
+          }
+      if (incoming) { sweep (s); resweeps++; }
+    }
+    std::cout << "INFO, VF::calculateLeftMostReachable, swept " << segments << " segments, " << resweeps << " re-swept for deletions spanning a cut" << std::endl;
+  }
+
+  std::cout << "INFO, VF::calculateLeftMostReachable, done" << std::endl;
+}
+
+/**
+ * @brief   compute left-most reachable vertex from each variant position
+ *          using up to alpha-1 labeled edges, for every alpha of alphas in a
+ *          single sweep; reach[a] receives the result for alphas[a].
+ *          Deletions are the variants of varpos/varlen with negative length.
+ *          With piecewise, distance vectors are kept as lists of linear
+ *          pieces instead of alpha-1 ints.
+ */
+void calculateLeftMostReachable (std::vector<std::vector<int>> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const std::vector<int> &alphas, int threads = 1, bool piecewise = false)
+{
+  if (piecewise)
+    calculateLeftMostReachable_<PiecewiseDistances> (reach, pos_u, varpos, varlen, alphas, threads);
+  else
+    calculateLeftMostReachable_<DenseDistances> (reach, pos_u, varpos, varlen, alphas, threads);
+}
+
+/**
+ * @brief   compute left-most reachable vertex from each variant position
+ *          using up to alpha-1 labeled edges
+ */
+void calculateLeftMostReachable (std::vector<int> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const int &alpha, int threads = 1, bool piecewise = false)
+{
+  assert (reach.size() == pos_u.size());
+
+  std::vector<std::vector<int>> r;
+  calculateLeftMostReachable (r, pos_u, varpos, varlen, std::vector<int> (1, alpha), threads, piecewise);
+  reach.swap(r[0]);
+}
+
+/**
+ * @brief   map the input of calculateRightMostReachable to the mirrored
+ *          graph, vertex v -> x+1-v with x = last variant position. Deletion
+ *          edges become reversed, queries move to the vertex before each
+ *          variant position. Deletions ending beyond x are cut at x.
+ */
+void mirrorReachInput (const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, std::vector<int> &m_pos_u, std::vector<int> &m_varpos, std::vector<int> &m_varlen)
+{
+  const int x = pos_u.back();
+
+  m_pos_u.resize (pos_u.size());
+  for (std::size_t i = 0; i < pos_u.size(); i++) m_pos_u[pos_u.size()-1-i] = x + 1 - (pos_u[i] - 1);
+
+  m_varpos.clear(); m_varlen.clear();
+  for (std::size_t i = 0; i < varpos.size(); i++)
+  {
+    if (varlen[i] < 0) //only deletions
+    {
+      int from = varpos[i]; int to = std::min(varpos[i] + std::abs(varlen[i]), x);
+      if (to <= from) continue; //starts at or beyond x, never visited
+      m_varpos.push_back(x + 1 - to);
+      m_varlen.push_back(from - to);
+    }
+  }
+}
+
+/**
+ * @brief   map left-most reachable vertices of the mirrored graph back to
+ *          right-most reachable vertices, in the order of pos_u
+ */
+void mirrorReachOutput (std::vector<int> &reach, int x)
+{
+  std::reverse (reach.begin(), reach.end());
+  for (auto &r: reach) r = x + 1 - r;
+}
+
+/**
+ * @brief   compute right-most vertex reachable from the vertex before each
+ *          variant position using up to alpha-1 labeled edges, for every
+ *          alpha of alphas; the window of position i then spans pos_u[i] to
+ *          reach[a][i]. Runs the left-most sweep on the mirrored graph,
+ *          values beyond the last variant position are reported as it.
+ */
+void calculateRightMostReachable (std::vector<std::vector<int>> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const std::vector<int> &alphas, int threads = 1, bool piecewise = false)
+{
+  std::vector<int> m_pos_u, m_varpos, m_varlen;
+  mirrorReachInput (pos_u, varpos, varlen, m_pos_u, m_varpos, m_varlen);
+  calculateLeftMostReachable (reach, m_pos_u, m_varpos, m_varlen, alphas, threads, piecewise);
+  for (auto &r: reach) mirrorReachOutput (r, pos_u.back());
+}
+
+/**
+ * @brief   compute right-most vertex reachable from the vertex before each
+ *          variant position using up to alpha-1 labeled edges
+ */
+void calculateRightMostReachable (std::vector<int> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const int &alpha, int threads = 1, bool piecewise = false)
+{
+  assert (reach.size() == pos_u.size());
+
+  std::vector<std::vector<int>> r;
+  calculateRightMostReachable (r, pos_u, varpos, varlen, std::vector<int> (1, alpha), threads, piecewise);
+  reach.swap(r[0]);
+}
+
+/**
+ * @brief   left-most reachability over a graph that is read in position
+ *          order, e.g., from a stream of position-sorted variants. Deletions
+ *          are added in order of their source and queries asked in increasing
+ *          order of position, as in the sweep of calculateLeftMostReachable.
+ *          Only currentPos and the updates of deletions spanning the current
+ *          position are kept.
+ */
+class ReachStream
+{
+  public:
+
+    ReachStream (int alpha) : m(alpha-1), currentPos(alpha-1), b(1)
+    {
+      assert (alpha > 2); //the logic below requires this
+      currentPos.reset();
+    }
+
+    /**
+     * @brief   left-most vertex reaching vertex i using up to alpha-1
+     *          labeled edges, i must not precede earlier queries or sources
+     */
+    int reach (int i)
+    {
+      visitTargets (i);
+      int k = i - b, j = m - 1;
+      return (k > j) ? i - 1 - j : currentPos.get(j-k);
+    }
+
+    /**
+     * @brief   add deletion edge from -> to, from must not precede earlier
+     *          queries or sources
+     */
+    void addDeletion (int from, int to)
+    {
+      if (from < 1) return; //outside backbone, never visited
+
+      visitTargets (from);
+      visit (from);
+
+      auto it = updateAhead.find(to);
+      if (it == updateAhead.end()) it = updateAhead.emplace(to, currentPos.newUpdate(to)).first; //initialize
+
+      //take pairwise minimum with vector currentPos
+      currentPos.mergeInto (it->second);
+    }
+
+    /**
+     * @brief   lower bound of the reach of all vertices after the last query
+     *          or source, entries of currentPos and updates do not increase
+     */
+    int floor () const
+    {
+      int f = currentPos.get(m-1);
+      for (auto &u: updateAhead) f = std::min(f, u.second[m-1]);
+      return f;
+    }
+
+  private:
+
+    int m;
+    DenseDistances currentPos;
+    int b;  //vertex currentPos was last materialized at
+    std::map<int, DenseDistances::Update> updateAhead; //pending update of each target
+
+    //use labeled edges b -> ... -> i
+    void visit (int i)
+    {
+      if (i == b) return;
+      currentPos.shift (std::min(i - b, m), i);
+      b = i;
+    }
+
+    //use updates sent via in-coming unlabeled edges of targets up to vertex i
+    void visitTargets (int i)
+    {
+      while (!updateAhead.empty() && updateAhead.begin()->first <= i)
+      {
+        auto it = updateAhead.begin();
+        visit (it->first);
+        currentPos.mergeFrom (it->second);
+        currentPos.release (it->second);
+        updateAhead.erase (it);
+      }
+    }
+};
+
+#endif
@@ -0,0 +1,309 @@
+#ifndef VF_REACH_CACHE_HPP
+#define VF_REACH_CACHE_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "reach.hpp"
+
+/********* Binary window range cache (<vcf file>.vfr) ******/
+
+/*
+ * Layout (host byte order, all offsets from the start of the file):
+ *
+ *   VFRHeader                       magic, version
+ *   VFRSection[section_count]       directory, one entry per (key, alpha)
+ *   int32 reach[count] for each section, 64-byte aligned
+ *
+ * The window ranges depend on the variant positions, the deletion edges and
+ * alpha only. A section is therefore keyed by a hash of the positions and
+ * deletion edges rather than by the vcf file, and stays valid across changes
+ * of delta, the algorithm or unrelated records of the vcf file. A second,
+ * independent hash of the same input is stored with each section and must
+ * match too, so that a collision of the key does not return wrong ranges.
+ */
+
+struct VFRHeader
+{
+  char magic[4];            //"VFR\1"
+  uint32_t version;
+  uint32_t section_count;
+  uint32_t reserved;
+};
+
+struct VFRSection
+{
+  uint64_t key;             //ReachKey::key of the input
+  uint64_t check;           //ReachKey::check of the input
+  int32_t alpha;
+  uint32_t reserved;
+  uint64_t count;           //count of variant positions
+  uint64_t offset;          //file offset of reach
+};
+
+static const uint32_t VFR_VERSION = 2;
+
+inline std::string reachCacheFileName (const std::string &vcf_file) { return vcf_file + ".vfr"; }
+
+/**
+ * @brief  two independent hashes of the input of calculateLeftMostReachable,
+ *         i.e., variant positions and the deletion edges among varpos/varlen
+ */
+struct ReachKey
+{
+  uint64_t key;     //locates the sections of the input
+  uint64_t check;   //verified before a section is used
+};
+
+inline ReachKey reachKey (const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen)
+{
+  //key: multiply-xorshift mixing, check: FNV-1a over the bytes of each value
+  uint64_t h = 0x243f6a8885a308d3ull, f = 0xcbf29ce484222325ull;
+  auto mix = [&h, &f](uint64_t v)
+  {
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 32;
+    for (int b = 0; b < 8; b++) { f ^= (v >> (8 * b)) & 0xff; f *= 0x100000001b3ull; }
+  };
+
+  mix (pos_u.size());
+  for (auto p: pos_u) mix ((uint32_t) p);
+  for (std::size_t i = 0; i < varpos.size(); i++)
+    if (varlen[i] < 0) mix (((uint64_t) (uint32_t) varpos[i] << 32) | (uint32_t) -varlen[i]);
+  return ReachKey {h, f};
+}
+
+/**
+ * @brief  read-only view of a valid window range cache file
+ */
+class ReachCache
+{
+  public:
+
+    ReachCache (const std::string &vcf_file) : map(NULL), map_size(0)
+    {
+      struct stat st;
+      int fd = open(reachCacheFileName(vcf_file).c_str(), O_RDONLY);
+      if (fd < 0) return;
+      if (fstat(fd, &st) == 0 && (std::size_t) st.st_size >= sizeof(VFRHeader))
+      {
+        void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) { map = static_cast<const char*>(m); map_size = st.st_size; }
+      }
+      close(fd);
+
+      if (map != NULL && !valid()) { munmap(const_cast<char*>(map), map_size); map = NULL; map_size = 0; }
+    }
+
+    ~ReachCache () { if (map != NULL) munmap(const_cast<char*>(map), map_size); }
+
+    bool good () const { return map != NULL; }
+
+    const VFRHeader& header () const { return *reinterpret_cast<const VFRHeader*>(map); }
+    const VFRSection* sections () const { return reinterpret_cast<const VFRSection*>(map + sizeof(VFRHeader)); }
+
+    const int32_t* column (const VFRSection &s) const { return reinterpret_cast<const int32_t*>(map + s.offset); }
+
+    /**
+     * @brief  locate section matching both hashes of key, alpha and count
+     * @return NULL if absent
+     */
+    const VFRSection* find (const ReachKey &key, int alpha, std::size_t count) const
+    {
+      if (!good()) return NULL;
+      for (uint32_t i = 0; i < header().section_count; i++)
+      {
+        const VFRSection &s = sections()[i];
+        if (s.key == key.key && s.check == key.check && s.alpha == alpha && s.count == count) return &s;
+      }
+      return NULL;
+    }
+
+  private:
+
+    const char *map;
+    std::size_t map_size;
+
+    bool valid () const
+    {
+      const VFRHeader &h = header();
+      if (std::memcmp(h.magic, "VFR\1", 4) != 0 || h.version != VFR_VERSION) return false;
+      if (sizeof(VFRHeader) + h.section_count * sizeof(VFRSection) > map_size) return false;
+      for (uint32_t i = 0; i < h.section_count; i++)
+      {
+        const VFRSection &s = sections()[i];
+        if (s.offset + s.count * sizeof(int32_t) > map_size) return false;
+      }
+      return true;
+    }
+};
+
+/**
+ * @brief  add (or replace) the sections (key, alphas[a]) with reach[a] in the
+ *         cache file, other sections are carried over. The new file is
+ *         written aside and renamed over the old one.
+ */
+inline void saveReachCache (const std::string &vcf_file, const ReachKey &key, const std::vector<int> &alphas, const std::vector<const std::vector<int>*> &reach)
+{
+  assert (alphas.size() == reach.size());
+  if (alphas.empty()) return;
+
+  //sections to write: old ones (except those being replaced) followed by the new ones
+  std::vector<VFRSection> dir;
+  std::vector<const int32_t*> cols;
+  ReachCache old (vcf_file);
+  if (old.good())
+    for (uint32_t i = 0; i < old.header().section_count; i++)
+    {
+      const VFRSection &s = old.sections()[i];
+      if (s.key == key.key && s.check == key.check && std::find(alphas.begin(), alphas.end(), s.alpha) != alphas.end()) continue;
+      dir.push_back(s);
+      cols.push_back(old.column(s));
+    }
+
+  for (std::size_t a = 0; a < alphas.size(); a++)
+  {
+    VFRSection s;
+    std::memset(&s, 0, sizeof(s));
+    s.key = key.key; s.check = key.check; s.alpha = alphas[a]; s.count = reach[a]->size();
+    dir.push_back(s);
+    cols.push_back(reach[a]->data());
+  }
+
+  uint64_t offset = sizeof(VFRHeader) + dir.size() * sizeof(VFRSection);
+  for (auto &d: dir)
+  {
+    offset = (offset + 63) & ~63ull;
+    d.offset = offset;
+    offset += d.count * sizeof(int32_t);
+  }
+
+  VFRHeader h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "VFR\1", 4);
+  h.version = VFR_VERSION;
+  h.section_count = dir.size();
+
+  std::string tmp = reachCacheFileName(vcf_file) + ".tmp." + std::to_string(getpid());
+  FILE *fp = std::fopen(tmp.c_str(), "wb");
+  if (fp == NULL)
+  {
+    std::cout << "INFO, VF::saveReachCache, unable to write cache file " << reachCacheFileName(vcf_file) << std::endl;
+    return;
+  }
+
+  static const char pad[64] = {0};
+  bool ok = std::fwrite(&h, sizeof(h), 1, fp) == 1;
+  ok = ok && std::fwrite(dir.data(), sizeof(VFRSection), dir.size(), fp) == dir.size();
+  uint64_t written = sizeof(VFRHeader) + dir.size() * sizeof(VFRSection);
+  for (std::size_t i = 0; i < dir.size() && ok; i++)
+  {
+    ok = std::fwrite(pad, 1, dir[i].offset - written, fp) == dir[i].offset - written;
+    ok = ok && std::fwrite(cols[i], sizeof(int32_t), dir[i].count, fp) == dir[i].count;
+    written = dir[i].offset + dir[i].count * sizeof(int32_t);
+  }
+  ok = (std::fclose(fp) == 0) && ok;
+
+  if (!ok || std::rename(tmp.c_str(), reachCacheFileName(vcf_file).c_str()) != 0)
+  {
+    std::remove(tmp.c_str());
+    std::cout << "INFO, VF::saveReachCache, unable to write cache file " << reachCacheFileName(vcf_file) << std::endl;
+    return;
+  }
+  std::cout << "INFO, VF::saveReachCache, saved window ranges of " << alphas.size() << " alpha values to " << reachCacheFileName(vcf_file) << std::endl;
+}
+
+/**
+ * @brief   calculateLeftMostReachable for every alpha of alphas; with
+ *          use_cache, results are loaded from <vcf file>.vfr where present,
+ *          the others are computed in one sweep and added to the file
+ */
+void calculateLeftMostReachable (std::vector<std::vector<int>> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const std::vector<int> &alphas, int threads, bool piecewise, const std::string &vcf_file, bool use_cache)
+{
+  if (!use_cache)
+  {
+    calculateLeftMostReachable (reach, pos_u, varpos, varlen, alphas, threads, piecewise);
+    return;
+  }
+
+  ReachKey key = reachKey (pos_u, varpos, varlen);
+  reach.assign (alphas.size(), std::vector<int> ());
+
+  std::vector<int> missing;
+  {
+    ReachCache cache (vcf_file);
+    for (std::size_t a = 0; a < alphas.size(); a++)
+    {
+      const VFRSection *s = cache.find (key, alphas[a], pos_u.size());
+      if (s == NULL) { missing.push_back(alphas[a]); continue; }
+      reach[a].assign (cache.column(*s), cache.column(*s) + s->count);
+    }
+  }
+  if (missing.size() < alphas.size())
+    std::cout << "INFO, VF::calculateLeftMostReachable, loaded window ranges of " << alphas.size() - missing.size() << " alpha values from " << reachCacheFileName(vcf_file) << std::endl;
+  if (missing.empty()) return;
+
+  std::vector<std::vector<int>> computed;
+  calculateLeftMostReachable (computed, pos_u, varpos, varlen, missing, threads, piecewise);
+
+  std::vector<const std::vector<int>*> saved;
+  for (std::size_t a = 0, k = 0; a < alphas.size(); a++)
+    if (k < missing.size() && alphas[a] == missing[k])
+    {
+      reach[a].swap(computed[k]);
+      saved.push_back(&reach[a]);
+      k++;
+    }
+  saveReachCache (vcf_file, key, missing, saved);
+}
+
+/**
+ * @brief   calculateLeftMostReachable for a single alpha, with use_cache
+ *          loaded from or added to <vcf file>.vfr
+ */
+void calculateLeftMostReachable (std::vector<int> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const int &alpha, int threads, bool piecewise, const std::string &vcf_file, bool use_cache)
+{
+  assert (reach.size() == pos_u.size());
+
+  std::vector<std::vector<int>> r;
+  calculateLeftMostReachable (r, pos_u, varpos, varlen, std::vector<int> (1, alpha), threads, piecewise, vcf_file, use_cache);
+  reach.swap(r[0]);
+}
+
+/**
+ * @brief   calculateRightMostReachable for every alpha of alphas, with
+ *          use_cache loaded from or added to <vcf file>.vfr. The mirrored
+ *          input hashes to its own key.
+ */
+void calculateRightMostReachable (std::vector<std::vector<int>> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const std::vector<int> &alphas, int threads, bool piecewise, const std::string &vcf_file, bool use_cache)
+{
+  std::vector<int> m_pos_u, m_varpos, m_varlen;
+  mirrorReachInput (pos_u, varpos, varlen, m_pos_u, m_varpos, m_varlen);
+  calculateLeftMostReachable (reach, m_pos_u, m_varpos, m_varlen, alphas, threads, piecewise, vcf_file, use_cache);
+  for (auto &r: reach) mirrorReachOutput (r, pos_u.back());
+}
+
+/**
+ * @brief   calculateRightMostReachable for a single alpha, with use_cache
+ *          loaded from or added to <vcf file>.vfr
+ */
+void calculateRightMostReachable (std::vector<int> &reach, const std::vector<int> &pos_u, const std::vector<int> &varpos, const std::vector<int> &varlen, const int &alpha, int threads, bool piecewise, const std::string &vcf_file, bool use_cache)
+{
+  assert (reach.size() == pos_u.size());
+
+  std::vector<std::vector<int>> r;
+  calculateRightMostReachable (r, pos_u, varpos, varlen, std::vector<int> (1, alpha), threads, piecewise, vcf_file, use_cache);
+  reach.swap(r[0]);
+}
+
+#endif
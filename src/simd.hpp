@@ -0,0 +1,370 @@
+#ifndef VF_SIMD_HPP
+#define VF_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VF_X86 1
+#endif
+
+/********* Vectorized kernels, selected at runtime by CPU feature detection ******/
+
+/**
+ * @brief  common tail of the line tokenizers: scalar scan of [p, end),
+ *         k columns have been found so far and column k starts at col[k]
+ */
+inline const char* tokenizeLine_tail (const char *p, const char *end, int ncols, const char **col, std::size_t *len, int &k)
+{
+  for (; p < end && *p != '\n'; p++)
+  {
+    if (*p == '\t' && k < ncols)
+    {
+      len[k] = p - col[k];
+      if (++k < ncols) col[k] = p + 1;
+    }
+  }
+  if (k < ncols) { len[k] = p - col[k]; k++; } //last column ends with the line
+  return p;
+}
+
+/**
+ * @brief  split a line into its first ncols tab-separated columns and locate
+ *         the end of line, in a single pass over the text
+ * @return pointer to the terminating '\n' (or end), k = count of columns found
+ */
+inline const char* tokenizeLine_scalar (const char *s, const char *end, int ncols, const char **col, std::size_t *len, int &k)
+{
+  k = 0; col[0] = s;
+  return tokenizeLine_tail (s, end, ncols, col, len, k);
+}
+
+/**
+ * @brief  parse the allele index starting at s and mark it in the bitmap seen
+ *         if it lies in [1, n_alt]
+ * @return pointer past the index
+ */
+inline const char* markAlleleIndex (const char *s, const char *end, int n_alt, uint64_t *seen)
+{
+  int a = 0;
+  for (; s < end && *s >= '0' && *s <= '9'; s++)
+    if (a <= n_alt) a = 10 * a + (*s - '0');
+  if (a > 0 && a <= n_alt) seen[a >> 6] |= 1ull << (a & 63);
+  return s;
+}
+
+/**
+ * @brief  mark every allele index in [1, n_alt] occurring in genotype-only
+ *         sample columns [s, end) (FORMAT = GT, e.g., "0|1\t1/0\t./."),
+ *         s must start a sample column
+ */
+inline void scanGenotypes_scalar (const char *s, const char *end, int n_alt, uint64_t *seen)
+{
+  while (s < end)
+  {
+    if (*s >= '0' && *s <= '9') s = markAlleleIndex (s, end, n_alt, seen);
+    else s++;
+  }
+}
+
+/**
+ * @brief  pairwise minimum dst[i] = min(dst[i], src[i]) for i in [0, n)
+ */
+inline void minMerge_scalar (int *dst, const int *src, std::size_t n)
+{
+  for (std::size_t i = 0; i < n; i++)
+    if (src[i] < dst[i]) dst[i] = src[i];
+}
+
+#ifdef VF_X86
+
+inline const char* tokenizeLine_sse2 (const char *s, const char *end, int ncols, const char **col, std::size_t *len, int &k)
+{
+  k = 0; col[0] = s;
+  const __m128i tab = _mm_set1_epi8('\t'), nl = _mm_set1_epi8('\n');
+  const char *p = s;
+
+  for (; p + 16 <= end; p += 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    uint32_t m_nl = _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+
+    if (k < ncols)
+    {
+      uint32_t m_tab = _mm_movemask_epi8(_mm_cmpeq_epi8(v, tab));
+      if (m_nl) m_tab &= (m_nl & (0u - m_nl)) - 1; //only tabs before the newline
+      for (; m_tab && k < ncols; m_tab &= m_tab - 1)
+      {
+        const char *t = p + __builtin_ctz(m_tab);
+        len[k] = t - col[k];
+        if (++k < ncols) col[k] = t + 1;
+      }
+    }
+
+    if (m_nl)
+      return tokenizeLine_tail (p + __builtin_ctz(m_nl), end, ncols, col, len, k);
+  }
+  return tokenizeLine_tail (p, end, ncols, col, len, k);
+}
+
+__attribute__((target("avx2")))
+inline const char* tokenizeLine_avx2 (const char *s, const char *end, int ncols, const char **col, std::size_t *len, int &k)
+{
+  k = 0; col[0] = s;
+  const __m256i tab = _mm256_set1_epi8('\t'), nl = _mm256_set1_epi8('\n');
+  const char *p = s;
+
+  for (; p + 32 <= end; p += 32)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    uint32_t m_nl = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl));
+
+    if (k < ncols)
+    {
+      uint32_t m_tab = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, tab));
+      if (m_nl) m_tab &= (m_nl & (0u - m_nl)) - 1; //only tabs before the newline
+      for (; m_tab && k < ncols; m_tab &= m_tab - 1)
+      {
+        const char *t = p + __builtin_ctz(m_tab);
+        len[k] = t - col[k];
+        if (++k < ncols) col[k] = t + 1;
+      }
+    }
+
+    if (m_nl)
+      return tokenizeLine_tail (p + __builtin_ctz(m_nl), end, ncols, col, len, k);
+  }
+  return tokenizeLine_tail (p, end, ncols, col, len, k);
+}
+
+/* The genotype kernels classify a block of bytes as digits, and a digit as a
+ * single-digit allele index if neither neighbour is a digit. Single-digit
+ * indices are turned into a bit (1 << index) by a pshufb lookup and OR-ed
+ * into an accumulator; the rare multi-digit indices (>9) are parsed from
+ * their first digit by markAlleleIndex. For n_alt <= 9 the scan stops as
+ * soon as every ALT index has been seen. */
+
+__attribute__((target("avx2")))
+inline __m256i digitMask_avx2 (const char *p, __m256i &d)  //d = byte - '0', mask = 0xff at digits
+{
+  d = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), _mm256_set1_epi8('0'));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+}
+
+__attribute__((target("avx2")))
+inline uint64_t reduceAlleleBits_avx2 (__m256i acc_lo, __m256i acc_hi)
+{
+  alignas(32) uint8_t lo[32], hi[32];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lo), acc_lo);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(hi), acc_hi);
+  uint64_t b_lo = 0, b_hi = 0;
+  for (int i = 0; i < 32; i++) { b_lo |= lo[i]; b_hi |= hi[i]; }
+  return b_lo | (b_hi << 8);
+}
+
+__attribute__((target("avx2")))
+inline void scanGenotypes_avx2 (const char *s, const char *end, int n_alt, uint64_t *seen)
+{
+  const __m256i lut_lo = _mm256_setr_epi8(1,2,4,8,16,32,64,(char)128,0,0,0,0,0,0,0,0, 1,2,4,8,16,32,64,(char)128,0,0,0,0,0,0,0,0);
+  const __m256i lut_hi = _mm256_setr_epi8(0,0,0,0,0,0,0,0,1,2,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,1,2,0,0,0,0,0,0);
+  const uint64_t want = (n_alt <= 9) ? ((2ull << n_alt) - 2) : 0;
+  __m256i acc_lo = _mm256_setzero_si256(), acc_hi = _mm256_setzero_si256();
+  uint64_t found = 0;
+
+  const char *p = s;
+  for (int iter = 1; p + 33 <= end; p += 32, iter++)
+  {
+    __m256i d0, dl, dr;
+    __m256i dig0 = digitMask_avx2 (p, d0);
+    __m256i digl = digitMask_avx2 (p - 1, dl);
+    __m256i digr = digitMask_avx2 (p + 1, dr);
+
+    __m256i single = _mm256_andnot_si256(_mm256_or_si256(digl, digr), dig0);
+    __m256i idx = _mm256_and_si256(d0, single);   //non-single bytes look up index 0 (REF)
+    acc_lo = _mm256_or_si256(acc_lo, _mm256_shuffle_epi8(lut_lo, idx));
+    acc_hi = _mm256_or_si256(acc_hi, _mm256_shuffle_epi8(lut_hi, idx));
+
+    uint32_t multi = _mm256_movemask_epi8(_mm256_andnot_si256(digl, _mm256_and_si256(dig0, digr)));
+    for (; multi; multi &= multi - 1)
+      markAlleleIndex (p + __builtin_ctz(multi), end, n_alt, seen);
+
+    if (want && (iter & 15) == 0 && ((found = reduceAlleleBits_avx2 (acc_lo, acc_hi)) & want) == want) break;
+  }
+
+  if (!(want && (found & want) == want))
+  {
+    while (p < end && *p >= '0' && *p <= '9' && p[-1] >= '0' && p[-1] <= '9') p++; //finish an index begun above
+    scanGenotypes_scalar (p, end, n_alt, seen);
+  }
+  seen[0] |= reduceAlleleBits_avx2 (acc_lo, acc_hi) & ~1ull & (n_alt < 63 ? (2ull << n_alt) - 1 : ~0ull);
+}
+
+__attribute__((target("avx512bw")))
+inline uint64_t reduceAlleleBits_avx512 (__m512i acc_lo, __m512i acc_hi)
+{
+  alignas(64) uint8_t lo[64], hi[64];
+  _mm512_store_si512(lo, acc_lo);
+  _mm512_store_si512(hi, acc_hi);
+  uint64_t b_lo = 0, b_hi = 0;
+  for (int i = 0; i < 64; i++) { b_lo |= lo[i]; b_hi |= hi[i]; }
+  return b_lo | (b_hi << 8);
+}
+
+__attribute__((target("avx512bw")))
+inline void scanGenotypes_avx512 (const char *s, const char *end, int n_alt, uint64_t *seen)
+{
+  const __m512i zero = _mm512_set1_epi8('0'), nine = _mm512_set1_epi8(9);
+  const __m512i lut_lo = _mm512_set4_epi32(0, 0, (int) 0x80402010, 0x08040201); //bytes 1,2,4,...,128,0,...
+  const __m512i lut_hi = _mm512_set4_epi32(0, 0x0201, 0, 0);                   //bytes 0,...,0,1,2,0,...
+  const uint64_t want = (n_alt <= 9) ? ((2ull << n_alt) - 2) : 0;
+  __m512i acc_lo = _mm512_setzero_si512(), acc_hi = _mm512_setzero_si512();
+  uint64_t found = 0;
+
+  const char *p = s;
+  uint64_t prev = 0;  //s[-1] starts no index, it is a tab
+  for (int iter = 1; p + 65 <= end; p += 64, iter++)
+  {
+    __m512i d = _mm512_sub_epi8(_mm512_loadu_si512(p), zero);
+    uint64_t dig = _mm512_cmple_epu8_mask(d, nine);
+    uint64_t digl = (dig << 1) | prev;
+    uint64_t digr = (dig >> 1) | ((uint64_t) (p[64] >= '0' && p[64] <= '9') << 63);
+    prev = dig >> 63;
+
+    uint64_t single = dig & ~digl & ~digr;
+    acc_lo = _mm512_or_si512(acc_lo, _mm512_maskz_shuffle_epi8(single, lut_lo, d));
+    acc_hi = _mm512_or_si512(acc_hi, _mm512_maskz_shuffle_epi8(single, lut_hi, d));
+
+    for (uint64_t multi = dig & ~digl & digr; multi; multi &= multi - 1)
+      markAlleleIndex (p + __builtin_ctzll(multi), end, n_alt, seen);
+
+    if (want && (iter & 7) == 0 && ((found = reduceAlleleBits_avx512 (acc_lo, acc_hi)) & want) == want) break;
+  }
+
+  if (!(want && (found & want) == want))
+  {
+    while (p < end && *p >= '0' && *p <= '9' && p[-1] >= '0' && p[-1] <= '9') p++; //finish an index begun above
+    scanGenotypes_scalar (p, end, n_alt, seen);
+  }
+  seen[0] |= reduceAlleleBits_avx512 (acc_lo, acc_hi) & ~1ull & (n_alt < 63 ? (2ull << n_alt) - 1 : ~0ull);
+}
+
+__attribute__((target("avx2")))
+inline void minMerge_avx2 (int *dst, const int *src, std::size_t n)
+{
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32)  //4 independent vectors per iteration
+  {
+    __m256i a0 = _mm256_min_epi32 (_mm256_loadu_si256((const __m256i*)(dst + i)),      _mm256_loadu_si256((const __m256i*)(src + i)));
+    __m256i a1 = _mm256_min_epi32 (_mm256_loadu_si256((const __m256i*)(dst + i + 8)),  _mm256_loadu_si256((const __m256i*)(src + i + 8)));
+    __m256i a2 = _mm256_min_epi32 (_mm256_loadu_si256((const __m256i*)(dst + i + 16)), _mm256_loadu_si256((const __m256i*)(src + i + 16)));
+    __m256i a3 = _mm256_min_epi32 (_mm256_loadu_si256((const __m256i*)(dst + i + 24)), _mm256_loadu_si256((const __m256i*)(src + i + 24)));
+    _mm256_storeu_si256((__m256i*)(dst + i), a0);
+    _mm256_storeu_si256((__m256i*)(dst + i + 8), a1);
+    _mm256_storeu_si256((__m256i*)(dst + i + 16), a2);
+    _mm256_storeu_si256((__m256i*)(dst + i + 24), a3);
+  }
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_min_epi32 (_mm256_loadu_si256((const __m256i*)(dst + i)), _mm256_loadu_si256((const __m256i*)(src + i))));
+  minMerge_scalar (dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+inline void minMerge_avx512 (int *dst, const int *src, std::size_t n)
+{
+  const __mmask16 all = 0xffff; //maskz form, the unmasked intrinsic trips -Wmaybe-uninitialized in gcc headers
+  std::size_t i = 0;
+  for (; i + 64 <= n; i += 64)  //4 independent vectors per iteration
+  {
+    __m512i a0 = _mm512_maskz_min_epi32 (all, _mm512_loadu_si512(dst + i),      _mm512_loadu_si512(src + i));
+    __m512i a1 = _mm512_maskz_min_epi32 (all, _mm512_loadu_si512(dst + i + 16), _mm512_loadu_si512(src + i + 16));
+    __m512i a2 = _mm512_maskz_min_epi32 (all, _mm512_loadu_si512(dst + i + 32), _mm512_loadu_si512(src + i + 32));
+    __m512i a3 = _mm512_maskz_min_epi32 (all, _mm512_loadu_si512(dst + i + 48), _mm512_loadu_si512(src + i + 48));
+    _mm512_storeu_si512(dst + i, a0);
+    _mm512_storeu_si512(dst + i + 16, a1);
+    _mm512_storeu_si512(dst + i + 32, a2);
+    _mm512_storeu_si512(dst + i + 48, a3);
+  }
+  for (; i + 16 <= n; i += 16)
+    _mm512_storeu_si512(dst + i, _mm512_maskz_min_epi32 (all, _mm512_loadu_si512(dst + i), _mm512_loadu_si512(src + i)));
+  if (i < n) //masked tail
+  {
+    __mmask16 m = (__mmask16) ((1u << (n - i)) - 1);
+    _mm512_mask_storeu_epi32(dst + i, m, _mm512_maskz_min_epi32 (m, _mm512_maskz_loadu_epi32(m, dst + i), _mm512_maskz_loadu_epi32(m, src + i)));
+  }
+}
+
+#endif
+
+typedef const char* (*TokenizeLineFn) (const char*, const char*, int, const char**, std::size_t*, int&);
+
+inline TokenizeLineFn selectTokenizeLine ()
+{
+#ifdef VF_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return tokenizeLine_avx2;
+  return tokenizeLine_sse2;
+#else
+  return tokenizeLine_scalar;
+#endif
+}
+
+/**
+ * @brief  split a line into its first ncols tab-separated columns and locate
+ *         the end of line (runtime dispatch to the widest supported kernel)
+ * @return pointer to the terminating '\n' (or end), k = count of columns found
+ */
+inline const char* tokenizeLine (const char *s, const char *end, int ncols, const char **col, std::size_t *len, int &k)
+{
+  static const TokenizeLineFn fn = selectTokenizeLine();
+  return fn (s, end, ncols, col, len, k);
+}
+
+typedef void (*ScanGenotypesFn) (const char*, const char*, int, uint64_t*);
+
+inline ScanGenotypesFn selectScanGenotypes ()
+{
+#ifdef VF_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw")) return scanGenotypes_avx512;
+  if (__builtin_cpu_supports("avx2")) return scanGenotypes_avx2;
+#endif
+  return scanGenotypes_scalar;
+}
+
+/**
+ * @brief  mark every allele index in [1, n_alt] occurring in genotype-only
+ *         sample columns [s, end) in the bitmap seen, which must hold
+ *         n_alt/64 + 1 words (runtime dispatch to the widest supported kernel).
+ *         s[-1] must be readable and s must start a sample column.
+ */
+inline void scanGenotypes (const char *s, const char *end, int n_alt, uint64_t *seen)
+{
+  static const ScanGenotypesFn fn = selectScanGenotypes();
+  fn (s, end, n_alt, seen);
+}
+
+typedef void (*MinMergeFn) (int*, const int*, std::size_t);
+
+inline MinMergeFn selectMinMerge ()
+{
+#ifdef VF_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return minMerge_avx512;
+  if (__builtin_cpu_supports("avx2")) return minMerge_avx2;
+#endif
+  return minMerge_scalar;
+}
+
+/**
+ * @brief  pairwise minimum dst[i] = min(dst[i], src[i]) for i in [0, n)
+ *         (runtime dispatch to the widest supported kernel),
+ *         dst and src must not overlap
+ */
+inline void minMerge (int *dst, const int *src, std::size_t n)
+{
+  static const MinMergeFn fn = selectMinMerge();
+  fn (dst, src, n);
+}
+
+#endif
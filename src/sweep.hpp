@@ -0,0 +1,66 @@
+#ifndef VF_SWEEP_HPP
+#define VF_SWEEP_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include "thread_pool.hpp"
+
+/********* Parameter sweep over (alpha, delta) pairs ******/
+
+/**
+ * @brief   run variant selection for every (alpha, delta) pair in points and
+ *          print one results table, rows are in the order of points.
+ *          prepare(alphas) computes per-alpha data (e.g., reachability) for
+ *          all distinct alphas at once and returns it in the same order,
+ *          select(alpha, delta, prepared) returns the result columns of one
+ *          point; the points run on a pool of worker threads.
+ */
+template <typename Prepared, typename Prepare, typename Select>
+void runSweep (const std::vector<std::pair<int,int>> &points, int threads, const std::vector<std::string> &columns, Prepare prepare, Select select)
+{
+  std::map<int, Prepared> prepared;
+  for (auto &p: points) prepared[p.first];
+
+  std::vector<int> alphas;
+  for (auto &a: prepared) alphas.push_back(a.first);
+
+  std::cout << "INFO, VF::runSweep, preparing " << alphas.size() << " distinct alpha values" << std::endl;
+  std::vector<Prepared> computed = prepare(alphas);
+  for (std::size_t i = 0; i < alphas.size(); i++) std::swap (prepared[alphas[i]], computed[i]);
+
+  std::vector<std::vector<long>> rows (points.size());
+  std::vector<double> seconds (points.size());
+
+  {
+    ThreadPool pool (std::min<int>(threads, points.size()));
+
+    std::cout << "INFO, VF::runSweep, running " << points.size() << " (alpha, delta) points" << std::endl;
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+      pool.submit([&, i]{
+        auto tStart = std::chrono::system_clock::now();
+        rows[i] = select(points[i].first, points[i].second, prepared.at(points[i].first));
+        std::chrono::duration<double> wctduration = (std::chrono::system_clock::now() - tStart);
+        seconds[i] = wctduration.count();
+      });
+    }
+    pool.wait();
+  }
+
+  std::cout << "INFO, VF::runSweep, results" << "\n";
+  std::cout << "alpha\tdelta";
+  for (auto &c: columns) std::cout << "\t" << c;
+  std::cout << "\tseconds\n";
+  for (std::size_t i = 0; i < points.size(); i++)
+  {
+    std::cout << points[i].first << "\t" << points[i].second;
+    for (auto v: rows[i]) std::cout << "\t" << v;
+    std::cout << "\t" << seconds[i] << "\n";
+  }
+  std::cout << std::flush;
+}
+
+#endif
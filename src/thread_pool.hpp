@@ -0,0 +1,142 @@
+#ifndef VF_THREAD_POOL_HPP
+#define VF_THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief   fixed set of worker threads executing submitted tasks, wait()
+ *          blocks until all submitted tasks have finished.
+ *          Each worker owns a task queue. Tasks submitted from outside the
+ *          pool are dealt to the queues in turn, tasks submitted by a task go
+ *          to the queue of its worker. A worker runs the tasks of its own
+ *          queue in submission order, so tasks submitted larger-first start
+ *          larger-first. A worker whose queue is empty steals the newest task
+ *          of another queue, leaving the older, larger ones to their owner,
+ *          so that unevenly sized tasks keep all workers busy.
+ */
+class ThreadPool
+{
+  public:
+
+    ThreadPool (int threads) : queued(0), pending(0), stop(false), next(0)
+    {
+      for (int i = 0; i < std::max(1, threads); i++)
+        queues.emplace_back(new Queue());
+      for (int i = 0; i < std::max(1, threads); i++)
+        workers.emplace_back([this, i]{ work(i); });
+    }
+
+    ~ThreadPool ()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m);
+        stop = true;
+      }
+      cv_task.notify_all();
+      for (auto &w: workers) w.join();
+    }
+
+    void submit (std::function<void()> task)
+    {
+      const Worker &self = current();
+      {
+        std::lock_guard<std::mutex> lock(m);
+        pending++;
+        Queue &q = *queues[self.pool == this ? self.index : next++ % queues.size()];
+        std::lock_guard<std::mutex> lock_q(q.m);
+        q.tasks.push_back(std::move(task));
+        queued++;
+      }
+      cv_task.notify_one();
+    }
+
+    void wait ()
+    {
+      std::unique_lock<std::mutex> lock(m);
+      cv_done.wait(lock, [this]{ return pending == 0; });
+    }
+
+    int size () const { return workers.size(); }
+
+  private:
+
+    struct Queue
+    {
+      std::mutex m;
+      std::deque<std::function<void()>> tasks;  //oldest at the front
+    };
+
+    struct Worker
+    {
+      const ThreadPool *pool;
+      int index;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::mutex m;
+    std::condition_variable cv_task, cv_done;
+    std::atomic<int> queued;  //in queues, not taken yet
+    int pending;              //submitted but not finished
+    bool stop;
+    std::size_t next;         //queue receiving the next outside task
+
+    //lock order: m before any Queue::m
+
+    /**
+     * @brief   pool and queue index of the calling thread, if it is a worker
+     */
+    static Worker& current ()
+    {
+      static thread_local Worker w = {NULL, -1};
+      return w;
+    }
+
+    bool take (int i, std::function<void()> &task)
+    {
+      for (std::size_t k = 0; k < queues.size(); k++)
+      {
+        Queue &q = *queues[(i + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.tasks.empty()) continue;
+        if (k == 0) { task = std::move(q.tasks.front()); q.tasks.pop_front(); }    //own queue, oldest
+        else { task = std::move(q.tasks.back()); q.tasks.pop_back(); }             //steal, newest
+        queued--;
+        return true;
+      }
+      return false;
+    }
+
+    void work (int i)
+    {
+      current().pool = this;
+      current().index = i;
+
+      while (true)
+      {
+        std::function<void()> task;
+        if (!take(i, task))
+        {
+          std::unique_lock<std::mutex> lock(m);
+          cv_task.wait(lock, [this]{ return stop || queued > 0; });
+          if (queued == 0) return;  //stop requested
+          continue;
+        }
+        task();
+        {
+          std::lock_guard<std::mutex> lock(m);
+          if (--pending == 0) cv_done.notify_all();
+        }
+      }
+    }
+};
+
+#endif
@@ -0,0 +1,596 @@
+#ifndef VF_VCF_HPP
+#define VF_VCF_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <cctype>
+#include <thread>
+#include <functional>
+#include "vcf_reader.hpp"
+#include "simd.hpp"
+#include "vcf_cache.hpp"
+
+#define VCF_MAX_COLS 10   //CHROM ... INFO, FORMAT and first sample
+#define VCF_MAX_GT_ALLELES 4096   //allele indices tracked when decoding genotypes
+
+/********* VCF parsing helpers ******/
+
+/**
+ * @brief  count ALT alleles of a record and check whether all alleles have
+ *         the length ref_len of REF, i.e., vcftools' N_ALLELES - 1 and the
+ *         complement of its --remove-indels filter
+ * @return false if the record is an indel (or a symbolic allele)
+ */
+inline bool countSNPAlleles (std::size_t ref_len, const char *alt, std::size_t alt_len, int &n_alt)
+{
+  n_alt = 0;
+  if (alt_len == 1 && alt[0] == '.') return true; //no alternate allele
+
+  const char *s = alt, *end = alt + alt_len;
+  while (s < end)
+  {
+    const char *t = static_cast<const char*>(std::memchr(s, ',', end - s));
+    if (t == NULL) t = end;
+    if (static_cast<std::size_t>(t - s) != ref_len) return false;
+    n_alt++;
+    s = t + 1;
+  }
+  return true;
+}
+
+/**
+ * @brief  look up value of key (e.g., "SVLEN=") inside INFO column
+ * @return pointer to the value or NULL if key is absent
+ */
+inline const char* findINFOValue (const char *info, std::size_t info_len, const char *key)
+{
+  std::size_t key_len = std::strlen(key);
+  const char *s = info, *end = info + info_len;
+  while (s + key_len <= end)
+  {
+    if (std::strncmp(s, key, key_len) == 0) return s + key_len;
+    const char *t = static_cast<const char*>(std::memchr(s, ';', end - s));
+    if (t == NULL) break;
+    s = t + 1;
+  }
+  return NULL;
+}
+
+/**
+ * @brief  count ALT alleles with a non-zero count in the INFO/AC list
+ *         (e.g., "AC=3,0,1" gives 2), ac points to the value of AC
+ */
+inline int countObservedAlleles_AC (const char *ac, const char *info_end)
+{
+  int observed = 0;
+  const char *s = ac;
+  while (s < info_end && *s != ';')
+  {
+    if (std::atoi(s) > 0) observed++;
+    while (s < info_end && *s != ',' && *s != ';') s++;
+    if (s < info_end && *s == ',') s++;
+  }
+  return observed;
+}
+
+/**
+ * @brief  count distinct ALT allele indices called in the genotypes of the
+ *         sample columns [samples, end), used when INFO/AC is absent
+ * @return -1 if FORMAT has no GT field
+ */
+inline int countObservedAlleles_GT (const char *format, std::size_t format_len, const char *samples, const char *end, int n_alt)
+{
+  //locate GT among the ':'-separated FORMAT keys
+  int gt_field = 0;
+  const char *f = format, *f_end = format + format_len;
+  while (!(f + 2 <= f_end && f[0] == 'G' && f[1] == 'T' && (f + 2 == f_end || f[2] == ':')))
+  {
+    f = static_cast<const char*>(std::memchr(f, ':', f_end - f));
+    if (f == NULL) return -1;
+    f++; gt_field++;
+  }
+
+  n_alt = std::min(n_alt, VCF_MAX_GT_ALLELES - 1);
+  uint64_t seen[VCF_MAX_GT_ALLELES / 64];
+  std::fill (seen, seen + (n_alt >> 6) + 1, 0);
+
+  if (format_len == 2)
+    scanGenotypes (samples, end, n_alt, seen);   //samples hold nothing but genotypes
+  else
+  {
+    const char *s = samples;
+    while (s < end)
+    {
+      for (int i = 0; i < gt_field && s < end && *s != '\t'; s++)  //skip fields before GT
+        if (*s == ':') i++;
+
+      //alleles are separated by '/' or '|', the GT field ends at ':' or tab
+      while (s < end && *s != ':' && *s != '\t')
+      {
+        if (*s >= '0' && *s <= '9') s = markAlleleIndex (s, end, n_alt, seen);
+        else s++;   //'.', '/' or '|'
+      }
+
+      if (s >= end) break;
+      const char *t = static_cast<const char*>(std::memchr(s, '\t', end - s));
+      s = (t == NULL) ? end : t + 1;   //next sample
+    }
+  }
+
+  int observed = 0;
+  for (int i = 0; i <= (n_alt >> 6); i++) observed += __builtin_popcountll(seen[i]);
+  return observed;
+}
+
+/**
+ * @brief  check if CHROM and POS columns of a record fall within the region
+ */
+inline bool inRegion (const char **col, const std::size_t *len, const VCFRegion &region)
+{
+  if (len[0] != region.chr.size() || std::strncmp(col[0], region.chr.data(), len[0]) != 0) return false;
+  return region.wholeChromosome() || region.contains(std::atoi(col[1]));
+}
+
+/**
+ * @brief  call f(col, len, k) for every record line within [begin, end),
+ *         which must hold complete lines only; col[k] marks the end of line.
+ *         header(line, eol) is called for every header line
+ */
+template <typename Header, typename Callback>
+void forEachRecordLine (const char *begin, const char *end, int ncols, Header &header, Callback &f)
+{
+  const char *col[VCF_MAX_COLS + 1]; std::size_t len[VCF_MAX_COLS];
+
+  while (begin < end)
+  {
+    int k;
+    const char *s = begin;
+    const char *eol = tokenizeLine (s, end, ncols, col, len, k);
+    begin = eol + 1;
+
+    if (s == eol) continue;
+    if (*s == '#') { header(s, eol); continue; }
+    col[k] = eol;
+    if (eol[-1] == '\r') //tolerate CRLF line endings
+    {
+      col[k]--;
+      if (col[k-1] + len[k-1] == eol) len[k-1]--;
+    }
+    f(col, len, k);
+  }
+}
+
+/**
+ * @brief  call f(col, len, k) for every record line within [begin, end),
+ *         header lines are skipped
+ */
+template <typename Callback>
+void forEachRecordLine (const char *begin, const char *end, int ncols, Callback &f)
+{
+  auto skip = [](const char*, const char*) {};
+  forEachRecordLine (begin, end, ncols, skip, f);
+}
+
+/**
+ * @brief  call f(col, len, k) for every record line of the VCF file, where
+ *         col[i] and len[i] give the first k <= ncols tab-separated columns
+ *         and col[k] marks the end of line.
+ *         Header lines and empty lines are skipped. If the file is indexed,
+ *         only the blocks overlapping the region are read.
+ */
+template <typename Callback>
+void forEachVCFRecord (const std::string &vcf_file, const VCFRegion &region, int threads, int ncols, Callback f)
+{
+  assert (ncols > 0 && ncols <= VCF_MAX_COLS);
+
+  VCFReader reader (vcf_file, threads);
+  reader.seekRegion(region);
+  const char *begin, *end;
+
+  while (reader.next(begin, end))
+    forEachRecordLine (begin, end, ncols, f);
+}
+
+/**
+ * @brief  positions and values extracted from the records of one contig
+ */
+struct ContigVariants
+{
+  std::string chr;
+  std::vector<int> pos, val;
+};
+
+/**
+ * @brief  set of contigs selected for a whole-genome run,
+ *         an empty list selects every contig of the file
+ */
+struct VCFContigs
+{
+  std::vector<std::string> chrs;
+
+  bool contains (const char *chr, std::size_t len) const
+  {
+    if (chrs.empty()) return true;
+    for (auto &c: chrs)
+      if (c.size() == len && std::strncmp(c.data(), chr, len) == 0) return true;
+    return false;
+  }
+};
+
+/**
+ * @brief  extract one (position, value) pair per selected record read from
+ *         reader into out[b], grouped by contig in order of first appearance.
+ *         keep(col, len) selects records by CHROM/POS, then f(col, len, k,
+ *         pos, val) returns a bitmask of the outputs b receiving the record,
+ *         with the pair in pos[b] and val[b], or 0 to skip it, so records of
+ *         several kinds are sorted in a single pass.
+ *         With threads > 1, each chunk of text is split at newline boundaries
+ *         and the pieces are parsed concurrently into per-thread buffers,
+ *         which are then appended in file order, so the output is identical
+ *         to the serial parse.
+ */
+template <typename Keep, typename Sort>
+void parseVCFRecords (VCFReader &reader, int threads, int ncols, Keep keep, Sort f, std::vector<std::vector<ContigVariants>> &out)
+{
+  assert (ncols > 1 && ncols <= VCF_MAX_COLS);
+  assert (out.size() <= 32);
+
+  const std::size_t MIN_PIECE = 1 << 20;  //don't bother spawning threads for less text
+
+  std::vector<std::vector<std::vector<ContigVariants>>> local (std::max(threads, 1), std::vector<std::vector<ContigVariants>> (out.size()));
+
+  //a piece is parsed into runs of consecutive records of the same contig, per output
+  auto parsePiece = [&](const char *begin, const char *end, std::vector<std::vector<ContigVariants>> &runs)
+  {
+    int p[32], v[32];
+    auto g = [&](const char **col, const std::size_t *len, int k)
+    {
+      if (k < 2 || !keep(col, len)) return;
+      unsigned mask = f(col, len, k, p, v);
+      for (std::size_t b = 0; b < runs.size(); b++)
+      {
+        if (!(mask >> b & 1)) continue;
+        std::vector<ContigVariants> &r = runs[b];
+        if (r.empty() || r.back().chr.size() != len[0] || std::strncmp(r.back().chr.data(), col[0], len[0]) != 0)
+        {
+          r.emplace_back();
+          r.back().chr.assign(col[0], len[0]);
+        }
+        r.back().pos.push_back(p[b]); r.back().val.push_back(v[b]);
+      }
+    };
+    forEachRecordLine (begin, end, ncols, g);
+  };
+
+  auto merge = [&](std::vector<std::vector<ContigVariants>> &runs)
+  {
+    for (std::size_t b = 0; b < out.size(); b++)
+    {
+      for (auto &r: runs[b])
+      {
+        auto it = std::find_if(out[b].rbegin(), out[b].rend(), [&](const ContigVariants &c){ return c.chr == r.chr; });
+        if (it == out[b].rend()) { out[b].push_back(std::move(r)); continue; }
+        it->pos.insert(it->pos.end(), r.pos.begin(), r.pos.end());
+        it->val.insert(it->val.end(), r.val.begin(), r.val.end());
+      }
+      runs[b].clear();
+    }
+  };
+
+  const char *begin, *end;
+  while (reader.next(begin, end))
+  {
+    int pieces = std::min<std::size_t>(local.size(), 1 + (end - begin) / MIN_PIECE);
+
+    if (pieces == 1)
+    {
+      parsePiece (begin, end, local[0]);
+      merge (local[0]);
+      continue;
+    }
+
+    //split at newline boundaries into roughly equal pieces
+    std::vector<const char*> cut (1, begin);
+    for (int t = 1; t < pieces; t++)
+    {
+      const char *c = std::max(cut.back(), begin + (end - begin) / pieces * t);
+      c = static_cast<const char*>(std::memchr(c, '\n', end - c));
+      cut.push_back(c == NULL ? end : c + 1);
+    }
+    cut.push_back(end);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < pieces; t++)
+      workers.emplace_back(parsePiece, cut[t], cut[t+1], std::ref(local[t]));
+    for (auto &w: workers) w.join();
+
+    //merge in order
+    for (int t = 0; t < pieces; t++) merge (local[t]);
+  }
+}
+
+/**
+ * @brief  extract one (position, value) pair per selected record read from
+ *         reader, f(col, len, k, pos, val) returns false to skip a record
+ */
+template <typename Keep, typename Extract>
+void parseVCFRecords (VCFReader &reader, int threads, int ncols, Keep keep, Extract f, std::vector<ContigVariants> &out)
+{
+  std::vector<std::vector<ContigVariants>> outs (1);
+  outs[0].swap(out);
+  parseVCFRecords (reader, threads, ncols, keep, [&](const char **col, const std::size_t *len, int k, int *pos, int *val)
+  {
+    return f(col, len, k, pos[0], val[0]) ? 1u : 0u;
+  }, outs);
+  out.swap(outs[0]);
+}
+
+/**
+ * @brief  extract one (position, value) pair per record of the region,
+ *         f(col, len, k, pos, val) returns false to skip a record
+ */
+template <typename Extract>
+void parseVCFRecords (const std::string &vcf_file, const VCFRegion &region, int threads, int ncols, Extract f, std::vector<int> &pos, std::vector<int> &val)
+{
+  VCFReader reader (vcf_file, threads);
+  reader.seekRegion(region);
+
+  std::vector<ContigVariants> out;
+  parseVCFRecords (reader, threads, ncols, [&](const char **col, const std::size_t *len) { return inRegion (col, len, region); }, f, out);
+
+  assert (out.size() <= 1);
+  if (out.size() == 1) { pos.swap(out[0].pos); val.swap(out[0].val); }
+}
+
+/**
+ * @brief  extract one (position, value) pair per record of the selected
+ *         contigs in a single scan of the file, grouped by contig
+ */
+template <typename Extract>
+void parseVCFRecords (const std::string &vcf_file, const VCFContigs &contigs, int threads, int ncols, Extract f, std::vector<ContigVariants> &out)
+{
+  VCFReader reader (vcf_file, threads);
+  parseVCFRecords (reader, threads, ncols, [&](const char **col, const std::size_t *len) { return contigs.contains (col[0], len[0]); }, f, out);
+}
+
+/**
+ * @brief  sort the records of the selected contigs into the outputs out[b]
+ *         in a single scan of the file, f(col, len, k, pos, val) returns the
+ *         bitmask of outputs receiving the record, see above
+ */
+template <typename Sort>
+void parseVCFRecords (const std::string &vcf_file, const VCFContigs &contigs, int threads, int ncols, Sort f, std::vector<std::vector<ContigVariants>> &out)
+{
+  VCFReader reader (vcf_file, threads);
+  parseVCFRecords (reader, threads, ncols, [&](const char **col, const std::size_t *len) { return contigs.contains (col[0], len[0]); }, f, out);
+}
+
+/********* Record extractors ******/
+
+/**
+ * @brief  position and signed length of an insertion or deletion SV record
+ */
+inline bool extractSV (const char **col, const std::size_t *len, int k, int &pos, int &sz)
+{
+  if (k < 8) return false;
+
+  const char *type = findINFOValue (col[7], len[7], "SVTYPE=");
+  if (type == NULL) return false;
+
+  const char *l = findINFOValue (col[7], len[7], "SVLEN=");
+  pos = std::atoi(col[1]);
+  sz = (l == NULL) ? 0 : std::abs((int) std::atof(l)); //ignore sign
+
+  //only consider INSs and DELs
+  if (std::strncmp(type, "INS", 3) == 0)
+    return true;
+  else if (std::strncmp(type, "DEL", 3) == 0)
+  {
+    sz = -1 * sz; //negative for deletions
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief  position and signed length of an indel record,
+ *         this assumes that vcf record will contain "VT=INDEL" for indel variants
+ */
+inline bool extractIndel (const char **col, const std::size_t *len, int k, int &pos, int &var_size)
+{
+  static const std::string vt = "VT=INDEL";
+
+  if (k < 8) return false;
+  if (std::search(col[7], col[7] + len[7], vt.begin(), vt.end()) == col[7] + len[7]) return false;
+
+  //ref and alt sequences should only contain alphabetic letter
+  assert (std::all_of(col[3], col[3] + len[3], [](char c){ return std::isalpha(c); }));
+  assert (std::all_of(col[4], col[4] + len[4], [](char c){ return std::isalpha(c); }));
+
+  var_size = (int) len[4] - (int) len[3]; //alt - ref, -ve if deletion, +ve for insertion
+  pos = std::atoi(col[1]);
+  return var_size != 0;
+}
+
+/**
+ * @brief  position and count of alternate alleles of a SNP record, see parseVCF_SNP
+ */
+inline bool extractSNP (const char **col, const std::size_t *len, int k, int &pos, int &n_alt, bool observed_only)
+{
+  if (k < 5) return false;
+  if (!countSNPAlleles (len[3], col[4], len[4], n_alt)) return false;
+  pos = std::atoi(col[1]);
+
+  if (observed_only && n_alt > 0)
+  {
+    const char *ac = (k >= 8) ? findINFOValue (col[7], len[7], "AC=") : NULL;
+    if (ac != NULL)
+      n_alt = countObservedAlleles_AC (ac, col[7] + len[7]);
+    else if (k == 9 && col[8] + len[8] < col[9])
+    {
+      int observed = countObservedAlleles_GT (col[8], len[8], col[8] + len[8] + 1, col[9], n_alt);
+      if (observed >= 0) n_alt = observed;
+    }
+  }
+  return true;
+}
+
+/********* Single chromosome parsers ******/
+
+/**
+ * @brief  parse VCF file to record info of insertion and deletion SVs,
+ *         with use_cache the result is loaded from/saved to <vcf file>.vfc
+ */
+void parseVCF (const std::string &sv_vcf_file, const VCFRegion &region, std::vector<int> &svpos, std::vector<int> &svlen, int threads = 1, bool use_cache = false)
+{
+  if (use_cache && loadVariantCache (sv_vcf_file, VFC_SV, region, svpos, svlen)) return;
+
+  parseVCFRecords (sv_vcf_file, region, threads, 8, extractSV, svpos, svlen);
+
+  if (svpos.size() == 0 || svlen.size() == 0)
+  {
+    std::cerr << "ERROR, VF::parseVCF, count of SVs found is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
+    exit(1);
+  }
+
+  if (use_cache) saveVariantCache (sv_vcf_file, VFC_SV, region, svpos, svlen);
+}
+
+/**
+ * @brief  parse VCF file to record info of indels,
+ *         this assumes that vcf record will contain "VT=INDEL" for indel variants,
+ *         with use_cache the result is loaded from/saved to <vcf file>.vfc
+ */
+void parseVCF_indel (const std::string &vcf_file, const VCFRegion &region, std::vector<int> &indelpos, std::vector<int> &indellen, int threads = 1, bool use_cache = false)
+{
+  if (use_cache && loadVariantCache (vcf_file, VFC_INDEL, region, indelpos, indellen)) return;
+
+  std::cout << "INFO, VF::parseVCF_indel, extracting indels from vcf file" << std::endl;
+
+  parseVCFRecords (vcf_file, region, threads, 8, extractIndel, indelpos, indellen);
+
+  if (indelpos.size() == 0 || indellen.size() == 0)
+  {
+    std::cerr << "ERROR, VF::parseVCF_indel, count of indels found is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
+    exit(1);
+  }
+
+  if (use_cache) saveVariantCache (vcf_file, VFC_INDEL, region, indelpos, indellen);
+
+  std::cout << "INFO, VF::parseVCF_indel, done" << std::endl;
+}
+
+/**
+ * @brief  parse VCF file to record SNP positions and count of alternate alleles
+ *         at each position, this reproduces the output of
+ *         'vcftools --chr <id> --counts --remove-indels' in a single pass.
+ *         If observed_only is set, only ALT alleles with a non-zero INFO/AC
+ *         entry are counted; genotypes are decoded only when AC is absent.
+ *         With use_cache the result is loaded from/saved to <vcf file>.vfc
+ */
+void parseVCF_SNP (const std::string &vcf_file, const VCFRegion &region, std::vector<int> &snppos, std::vector<int> &snpcount, int threads = 1, bool observed_only = false, bool use_cache = false)
+{
+  VFCKind kind = observed_only ? VFC_SNP_OBSERVED : VFC_SNP;
+  if (use_cache && loadVariantCache (vcf_file, kind, region, snppos, snpcount)) return;
+
+  std::cout << "INFO, VF::parseVCF_SNP, extracting SNPs from vcf file" << std::endl;
+  if (observed_only) std::cout << "INFO, VF::parseVCF_SNP, counting only alternate alleles observed in INFO/AC or genotypes" << std::endl;
+
+  parseVCFRecords (vcf_file, region, threads, observed_only ? 9 : 5, [&](const char **col, const std::size_t *len, int k, int &pos, int &n_alt)
+  {
+    return extractSNP (col, len, k, pos, n_alt, observed_only);
+  }, snppos, snpcount);
+
+  if (snppos.size() == 0)
+  {
+    std::cerr << "ERROR, VF::parseVCF_SNP, count of SNPs is zero, did you provide the correct vcf file and chrommosome id?" << std::endl;
+    exit(1);
+  }
+
+  //keep only one record per loci
+  ignoreDuplicateSNPrecords(snppos, snpcount);
+  assert (std::is_sorted(snppos.begin(), snppos.end()));
+
+  if (use_cache) saveVariantCache (vcf_file, kind, region, snppos, snpcount);
+
+  std::cout << "INFO, VF::parseVCF_SNP, done" << std::endl;
+}
+
+/********* Whole-genome parsers, one scan of the file for all contigs ******/
+
+/**
+ * @brief  parse VCF file to record info of insertion and deletion SVs of
+ *         every selected contig
+ */
+void parseVCF (const std::string &sv_vcf_file, const VCFContigs &contigs, std::vector<ContigVariants> &out, int threads = 1)
+{
+  std::cout << "INFO, VF::parseVCF, extracting SVs of all selected chromosomes" << std::endl;
+  parseVCFRecords (sv_vcf_file, contigs, threads, 8, extractSV, out);
+  std::cout << "INFO, VF::parseVCF, SVs found on " << out.size() << " chromosomes" << std::endl;
+}
+
+/**
+ * @brief  parse VCF file to record info of indels of every selected contig
+ */
+void parseVCF_indel (const std::string &vcf_file, const VCFContigs &contigs, std::vector<ContigVariants> &out, int threads = 1)
+{
+  std::cout << "INFO, VF::parseVCF_indel, extracting indels of all selected chromosomes" << std::endl;
+  parseVCFRecords (vcf_file, contigs, threads, 8, extractIndel, out);
+  std::cout << "INFO, VF::parseVCF_indel, indels found on " << out.size() << " chromosomes" << std::endl;
+}
+
+/**
+ * @brief  parse VCF file to record SNP positions and count of alternate
+ *         alleles of every selected contig, see parseVCF_SNP above
+ */
+void parseVCF_SNP (const std::string &vcf_file, const VCFContigs &contigs, std::vector<ContigVariants> &out, int threads = 1, bool observed_only = false)
+{
+  std::cout << "INFO, VF::parseVCF_SNP, extracting SNPs of all selected chromosomes" << std::endl;
+
+  parseVCFRecords (vcf_file, contigs, threads, observed_only ? 9 : 5, [&](const char **col, const std::size_t *len, int k, int &pos, int &n_alt)
+  {
+    return extractSNP (col, len, k, pos, n_alt, observed_only);
+  }, out);
+
+  for (auto &c: out)
+  {
+    ignoreDuplicateSNPrecords(c.pos, c.val); //keep only one record per loci
+    assert (std::is_sorted(c.pos.begin(), c.pos.end()));
+  }
+  std::cout << "INFO, VF::parseVCF_SNP, SNPs found on " << out.size() << " chromosomes" << std::endl;
+}
+
+/**
+ * @brief  parse VCF file to record info of indels and of SNPs of every
+ *         selected contig, as parseVCF_indel and parseVCF_SNP above, but
+ *         sorting each record into indels or SNPs in a single scan
+ */
+void parseVCF_indel_SNP (const std::string &vcf_file, const VCFContigs &contigs, std::vector<ContigVariants> &indels, std::vector<ContigVariants> &snps, int threads = 1, bool observed_only = false)
+{
+  std::cout << "INFO, VF::parseVCF_indel_SNP, extracting indels and SNPs of all selected chromosomes" << std::endl;
+  if (observed_only) std::cout << "INFO, VF::parseVCF_indel_SNP, counting only alternate alleles observed in INFO/AC or genotypes" << std::endl;
+
+  std::vector<std::vector<ContigVariants>> out (2);
+  parseVCFRecords (vcf_file, contigs, threads, observed_only ? 9 : 8, [&](const char **col, const std::size_t *len, int k, int *pos, int *val) -> unsigned
+  {
+    unsigned mask = 0;
+    if (extractIndel (col, len, k, pos[0], val[0])) mask |= 1; //a record may be both, as with separate scans
+    if (extractSNP (col, len, k, pos[1], val[1], observed_only)) mask |= 2;
+    return mask;
+  }, out);
+  indels.swap(out[0]); snps.swap(out[1]);
+
+  for (auto &c: snps)
+  {
+    ignoreDuplicateSNPrecords(c.pos, c.val); //keep only one record per loci
+    assert (std::is_sorted(c.pos.begin(), c.pos.end()));
+  }
+  std::cout << "INFO, VF::parseVCF_indel_SNP, indels found on " << indels.size() << " chromosomes, SNPs found on " << snps.size() << " chromosomes" << std::endl;
+}
+
+#endif
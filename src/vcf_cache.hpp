@@ -0,0 +1,230 @@
+#ifndef VF_VCF_CACHE_HPP
+#define VF_VCF_CACHE_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vcf_reader.hpp"
+
+/********* Binary variant cache (<vcf file>.vfc) ******/
+
+/*
+ * Layout (host byte order, all offsets from the start of the file):
+ *
+ *   VFCHeader                       magic, version, size and mtime of the vcf file
+ *   VFCSection[section_count]       directory, one entry per parsed array pair
+ *   int32 pos[count], int32 val[count] for each section, 64-byte aligned
+ *
+ * A section holds the output of one parse (kind, chromosome and region), i.e.,
+ * positions and signed lengths for SVs and indels, positions and allele counts
+ * for SNPs. The columns can be used directly from the mapping.
+ */
+
+enum VFCKind { VFC_SV = 1, VFC_INDEL = 2, VFC_SNP = 3, VFC_SNP_OBSERVED = 4 };
+
+struct VFCHeader
+{
+  char magic[4];            //"VFC\1"
+  uint32_t version;
+  uint64_t source_size;     //size of the vcf file in bytes
+  int64_t source_mtime_sec; //modification time of the vcf file
+  int64_t source_mtime_nsec;
+  uint32_t section_count;
+  uint32_t reserved;
+};
+
+struct VFCSection
+{
+  uint32_t kind;
+  int32_t beg, end;         //region, 1-based inclusive
+  char chr[52];             //NUL-terminated chromosome id
+  uint64_t count;           //entries per column
+  uint64_t offset;          //file offset of pos column, val column follows
+};
+
+static const uint32_t VFC_VERSION = 1;
+
+inline std::string cacheFileName (const std::string &vcf_file) { return vcf_file + ".vfc"; }
+
+/**
+ * @brief  read-only view of a valid cache file
+ */
+class VariantCache
+{
+  public:
+
+    VariantCache (const std::string &vcf_file) : map(NULL), map_size(0)
+    {
+      struct stat src, st;
+      if (stat(vcf_file.c_str(), &src) != 0) return;
+
+      int fd = open(cacheFileName(vcf_file).c_str(), O_RDONLY);
+      if (fd < 0) return;
+      if (fstat(fd, &st) == 0 && (std::size_t) st.st_size >= sizeof(VFCHeader))
+      {
+        void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) { map = static_cast<const char*>(m); map_size = st.st_size; }
+      }
+      close(fd);
+
+      if (map != NULL && !valid(src)) { munmap(const_cast<char*>(map), map_size); map = NULL; map_size = 0; }
+    }
+
+    ~VariantCache () { if (map != NULL) munmap(const_cast<char*>(map), map_size); }
+
+    bool good () const { return map != NULL; }
+
+    const VFCHeader& header () const { return *reinterpret_cast<const VFCHeader*>(map); }
+    const VFCSection* sections () const { return reinterpret_cast<const VFCSection*>(map + sizeof(VFCHeader)); }
+
+    const int32_t* column (const VFCSection &s, int i) const
+    {
+      return reinterpret_cast<const int32_t*>(map + s.offset) + i * s.count;
+    }
+
+    /**
+     * @brief  locate section matching kind and region
+     * @return NULL if absent
+     */
+    const VFCSection* find (VFCKind kind, const VCFRegion &region) const
+    {
+      if (!good()) return NULL;
+      for (uint32_t i = 0; i < header().section_count; i++)
+      {
+        const VFCSection &s = sections()[i];
+        if (s.kind == (uint32_t) kind && s.beg == region.beg && s.end == region.end && region.chr == s.chr)
+          return &s;
+      }
+      return NULL;
+    }
+
+  private:
+
+    const char *map;
+    std::size_t map_size;
+
+    //cache must describe the current vcf file and be complete
+    bool valid (const struct stat &src) const
+    {
+      const VFCHeader &h = header();
+      if (std::memcmp(h.magic, "VFC\1", 4) != 0 || h.version != VFC_VERSION) return false;
+      if (h.source_size != (uint64_t) src.st_size || h.source_mtime_sec != (int64_t) src.st_mtim.tv_sec
+          || h.source_mtime_nsec != (int64_t) src.st_mtim.tv_nsec) return false;
+      if (sizeof(VFCHeader) + h.section_count * sizeof(VFCSection) > map_size) return false;
+      for (uint32_t i = 0; i < h.section_count; i++)
+      {
+        const VFCSection &s = sections()[i];
+        if (s.offset + 2 * s.count * sizeof(int32_t) > map_size || s.chr[sizeof(s.chr) - 1] != '\0') return false;
+      }
+      return true;
+    }
+};
+
+/**
+ * @brief  load positions and values of a previous parse from the cache file
+ * @return false if the cache is missing, stale or lacks this kind/region
+ */
+inline bool loadVariantCache (const std::string &vcf_file, VFCKind kind, const VCFRegion &region, std::vector<int> &pos, std::vector<int> &val)
+{
+  VariantCache cache (vcf_file);
+  const VFCSection *s = cache.find (kind, region);
+  if (s == NULL) return false;
+
+  pos.assign (cache.column(*s, 0), cache.column(*s, 0) + s->count);
+  val.assign (cache.column(*s, 1), cache.column(*s, 1) + s->count);
+  std::cout << "INFO, VF::loadVariantCache, loaded " << s->count << " records from " << cacheFileName(vcf_file) << std::endl;
+  return true;
+}
+
+/**
+ * @brief  add (or replace) the section of this kind/region in the cache file,
+ *         sections of a still valid cache are carried over. The new file is
+ *         written aside and renamed over the old one.
+ */
+inline void saveVariantCache (const std::string &vcf_file, VFCKind kind, const VCFRegion &region, const std::vector<int> &pos, const std::vector<int> &val)
+{
+  assert (pos.size() == val.size());
+
+  struct stat src;
+  if (stat(vcf_file.c_str(), &src) != 0 || region.chr.size() >= sizeof(VFCSection::chr)) return;
+
+  //sections to write: old ones (except the one being replaced) followed by the new one
+  std::vector<VFCSection> dir;
+  std::vector<const int32_t*> cols;
+  VariantCache old (vcf_file);
+  const VFCSection *replaced = old.find (kind, region);
+  if (old.good())
+    for (uint32_t i = 0; i < old.header().section_count; i++)
+      if (&old.sections()[i] != replaced)
+      {
+        dir.push_back(old.sections()[i]);
+        cols.push_back(old.column(old.sections()[i], 0));
+      }
+
+  VFCSection s;
+  std::memset(&s, 0, sizeof(s));
+  s.kind = kind; s.beg = region.beg; s.end = region.end; s.count = pos.size();
+  std::strncpy(s.chr, region.chr.c_str(), sizeof(s.chr) - 1);
+  dir.push_back(s);
+
+  uint64_t offset = sizeof(VFCHeader) + dir.size() * sizeof(VFCSection);
+  for (auto &d: dir)
+  {
+    offset = (offset + 63) & ~63ull;
+    d.offset = offset;
+    offset += 2 * d.count * sizeof(int32_t);
+  }
+
+  VFCHeader h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "VFC\1", 4);
+  h.version = VFC_VERSION;
+  h.source_size = src.st_size;
+  h.source_mtime_sec = src.st_mtim.tv_sec;
+  h.source_mtime_nsec = src.st_mtim.tv_nsec;
+  h.section_count = dir.size();
+
+  std::string tmp = cacheFileName(vcf_file) + ".tmp." + std::to_string(getpid());
+  FILE *fp = std::fopen(tmp.c_str(), "wb");
+  if (fp == NULL)
+  {
+    std::cout << "INFO, VF::saveVariantCache, unable to write cache file " << cacheFileName(vcf_file) << std::endl;
+    return;
+  }
+
+  static const char pad[64] = {0};
+  bool ok = std::fwrite(&h, sizeof(h), 1, fp) == 1;
+  ok = ok && std::fwrite(dir.data(), sizeof(VFCSection), dir.size(), fp) == dir.size();
+  uint64_t written = sizeof(VFCHeader) + dir.size() * sizeof(VFCSection);
+  for (std::size_t i = 0; i < dir.size() && ok; i++)
+  {
+    ok = std::fwrite(pad, 1, dir[i].offset - written, fp) == dir[i].offset - written;
+    if (i < cols.size())
+      ok = ok && std::fwrite(cols[i], sizeof(int32_t), 2 * dir[i].count, fp) == 2 * dir[i].count;
+    else
+    {
+      ok = ok && std::fwrite(pos.data(), sizeof(int32_t), pos.size(), fp) == pos.size();
+      ok = ok && std::fwrite(val.data(), sizeof(int32_t), val.size(), fp) == val.size();
+    }
+    written = dir[i].offset + 2 * dir[i].count * sizeof(int32_t);
+  }
+  ok = (std::fclose(fp) == 0) && ok;
+
+  if (!ok || std::rename(tmp.c_str(), cacheFileName(vcf_file).c_str()) != 0)
+  {
+    std::remove(tmp.c_str());
+    std::cout << "INFO, VF::saveVariantCache, unable to write cache file " << cacheFileName(vcf_file) << std::endl;
+    return;
+  }
+  std::cout << "INFO, VF::saveVariantCache, saved " << pos.size() << " records to " << cacheFileName(vcf_file) << std::endl;
+}
+
+#endif
@@ -0,0 +1,579 @@
+#ifndef VF_VCF_READER_HPP
+#define VF_VCF_READER_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <climits>
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief   genomic interval to be read from a VCF file,
+ *          coordinates are 1-based and inclusive
+ */
+struct VCFRegion
+{
+  std::string chr;
+  int beg, end;
+
+  VCFRegion (const std::string &chr, int beg = 1, int end = INT_MAX) : chr(chr), beg(beg), end(end) {}
+
+  bool wholeChromosome () const { return beg <= 1 && end == INT_MAX; }
+  bool contains (int pos) const { return pos >= beg && pos <= end; }
+};
+
+/**
+ * @brief   sequential reader for plain, gzip or BGZF (bgzip) compressed VCF files,
+ *          the format is detected from the first bytes of the file.
+ *          Text is handed out in chunks that always end at a line boundary.
+ *          Plain files are memory-mapped and handed out without copying.
+ *          For BGZF input, blocks are inflated in parallel by worker threads,
+ *          and the next batch of blocks is decoded while the caller parses the
+ *          current one. If a tabix (.tbi) or CSI (.csi) index is found next to
+ *          a BGZF file, seekRegion() restricts reading to the blocks which
+ *          overlap the requested region. Plain text is read from stdin if
+ *          the filename is "-".
+ */
+class VCFReader
+{
+  public:
+
+    VCFReader (const std::string &filename, int threads = 1)
+      : filename(filename), fp(NULL), gz(NULL), threads(std::max(1, threads)), consumed(0), eof(false),
+        indexed(false), chunk_idx(0), in_chunk(false), coffset(0),
+        map(NULL), map_size(0), map_pos(0)
+    {
+      if (filename == "-")
+      {
+        //stdin cannot be rewound, keep the bytes read for format detection
+        fp = stdin;
+        format = PLAIN;
+        buf.resize(2);
+        buf.resize(std::fread(buf.data(), 1, 2, fp));
+        if (buf.size() == 2 && (unsigned char) buf[0] == 0x1f && (unsigned char) buf[1] == 0x8b)
+        {
+          std::cerr << "ERROR, VF::VCFReader, compressed vcf input on stdin is not supported, decompress it first (e.g., with zcat)" << std::endl;
+          exit(1);
+        }
+        return;
+      }
+
+      fp = std::fopen(filename.c_str(), "rb");
+      if (fp == NULL)
+      {
+        std::cerr << "ERROR, VF::VCFReader, vcf file cannot be opened" << std::endl;
+        exit(1);
+      }
+
+      unsigned char h[18];
+      std::size_t n = std::fread(h, 1, 18, fp);
+      std::rewind(fp);
+
+      if (n >= 2 && h[0] == 0x1f && h[1] == 0x8b)
+      {
+        //BGZF: gzip member with FEXTRA flag carrying the 'BC' subfield
+        if (n == 18 && h[3] == 4 && h[12] == 'B' && h[13] == 'C')
+          format = BGZF;
+        else
+        {
+          format = GZIP;
+          std::fclose(fp); fp = NULL;
+          gz = gzopen(filename.c_str(), "rb");
+          if (gz == NULL)
+          {
+            std::cerr << "ERROR, VF::VCFReader, gzip compressed vcf file cannot be opened" << std::endl;
+            exit(1);
+          }
+          gzbuffer(gz, 1 << 20);
+        }
+      }
+      else
+      {
+        format = PLAIN;
+        mapFile();
+      }
+    }
+
+    ~VCFReader ()
+    {
+      if (pending.valid()) pending.wait();
+      if (map != NULL) munmap(map, map_size);
+      if (fp != NULL && fp != stdin) std::fclose(fp);
+      if (gz != NULL) gzclose(gz);
+    }
+
+    bool isCompressed () const { return format != PLAIN; }
+    bool isBGZF () const { return format == BGZF; }
+
+    /**
+     * @brief   restrict reading to the BGZF blocks that may contain records
+     *          overlapping the region, using <vcf>.tbi or <vcf>.csi index.
+     *          Must be called before the first call to next(). Records
+     *          outside the region may still be returned and should be
+     *          filtered by the caller.
+     * @return  false if no usable index was found (whole file is read)
+     */
+    bool seekRegion (const VCFRegion &region)
+    {
+      if (format != BGZF) return false;
+
+      std::vector<unsigned char> idx;
+      bool csi = false;
+      if (loadIndex (filename + ".csi", idx))
+        csi = true;
+      else if (!loadIndex (filename + ".tbi", idx))
+        return false;
+
+      std::vector<std::pair<uint64_t,uint64_t>> list;
+      if (!queryIndex (idx, csi, region, list))
+      {
+        std::cerr << "WARNING, VF::VCFReader, index could not be parsed, reading whole file" << std::endl;
+        return false;
+      }
+
+      std::cout << "INFO, VF::VCFReader, using " << (csi ? "CSI" : "tabix") << " index, " << list.size() << " chunk(s) to read" << std::endl;
+      chunks = list;
+      indexed = true;
+      return true;
+    }
+
+    /**
+     * @brief   fetch next chunk of complete lines as [begin, end),
+     *          the last line of the chunk is always terminated by '\n'
+     * @return  false when input is exhausted
+     */
+    bool next (const char *&begin, const char *&end)
+    {
+      if (map != NULL && map_pos < map_size)
+      {
+        //hand out the mapped file up to its last newline, no copy
+        const char *s = map + map_pos;
+        const char *nl = static_cast<const char*>(memrchr(s, '\n', map_size - map_pos));
+        if (nl != NULL)
+        {
+          begin = s; end = nl + 1;
+          map_pos = end - map;
+          if (map_pos == map_size) eof = true;
+          return true;
+        }
+        //trailing line without newline goes through buf
+        buf.assign(s, static_cast<const char*>(map + map_size));
+        map_pos = map_size;
+        eof = true;
+      }
+
+      //move leftover partial line to the front
+      buf.erase(buf.begin(), buf.begin() + consumed);
+      consumed = 0;
+
+      while (true)
+      {
+        std::size_t scanned = buf.size();
+        bool more = fill();
+
+        const char *s = buf.data();
+        const char *nl = NULL;
+        for (std::size_t i = buf.size(); i > scanned; i--)
+          if (s[i-1] == '\n') { nl = s + i - 1; break; }
+
+        if (nl != NULL)
+        {
+          consumed = nl + 1 - s;
+          begin = s; end = nl + 1;
+          return true;
+        }
+
+        if (!more)
+        {
+          if (buf.empty()) return false;
+          buf.push_back('\n'); //last line without newline
+          consumed = buf.size();
+          begin = buf.data(); end = begin + consumed;
+          return true;
+        }
+      }
+    }
+
+  private:
+
+    enum Format {PLAIN, GZIP, BGZF};
+
+    static const std::size_t CHUNK_SIZE = 1 << 24;   //bytes per read for plain/gzip input
+    static const int BGZF_BATCH_BLOCKS = 256;         //up to 16 MB of text per BGZF batch
+
+    std::string filename;
+    Format format;
+    FILE *fp;
+    gzFile gz;
+    int threads;
+
+    std::vector<char> buf;       //text handed out to the caller
+    std::size_t consumed;        //prefix of buf already handed out
+    bool eof;
+
+    std::vector<char> batch;     //BGZF batch being decoded in the background
+    std::future<int> pending;
+
+    //index-driven reading: sorted, merged [begin, end) virtual offset ranges
+    bool indexed;
+    std::vector<std::pair<uint64_t,uint64_t>> chunks;
+    std::size_t chunk_idx;
+    bool in_chunk;
+    uint64_t coffset;            //file offset of next block to read in current chunk
+
+    //memory-mapped plain input
+    char *map;
+    std::size_t map_size;
+    std::size_t map_pos;         //prefix of map already handed out
+
+    /**
+     * @brief   map a plain (regular) file into memory, fread() is used
+     *          as a fallback for pipes or if mmap fails
+     */
+    void mapFile ()
+    {
+      struct stat st;
+      if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) return;
+
+      void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+      if (m == MAP_FAILED) return;
+      madvise(m, st.st_size, MADV_SEQUENTIAL);
+
+      map = static_cast<char*>(m);
+      map_size = st.st_size;
+    }
+
+    /**
+     * @brief   append next piece of decompressed text to buf
+     * @return  false at end of input
+     */
+    bool fill ()
+    {
+      if (eof) return false;
+
+      if (format == PLAIN)
+      {
+        std::size_t old = buf.size();
+        buf.resize(old + CHUNK_SIZE);
+        std::size_t n = std::fread(buf.data() + old, 1, CHUNK_SIZE, fp);
+        buf.resize(old + n);
+        if (n == 0) eof = true;
+      }
+      else if (format == GZIP)
+      {
+        std::size_t old = buf.size();
+        buf.resize(old + CHUNK_SIZE);
+        int n = gzread(gz, buf.data() + old, CHUNK_SIZE);
+        if (n < 0)
+        {
+          std::cerr << "ERROR, VF::VCFReader, gzip decompression failed" << std::endl;
+          exit(1);
+        }
+        buf.resize(old + n);
+        if (n == 0) eof = true;
+      }
+      else
+      {
+        if (!pending.valid())
+          pending = std::async(std::launch::async, &VCFReader::decodeBGZFBatch, this);
+
+        int status = pending.get();
+        if (status < 0)
+        {
+          std::cerr << "ERROR, VF::VCFReader, malformed BGZF block" << std::endl;
+          exit(1);
+        }
+
+        buf.insert(buf.end(), batch.begin(), batch.end());
+
+        if (status == 0)
+          eof = true;
+        else  //decode next batch while the caller parses this one
+          pending = std::async(std::launch::async, &VCFReader::decodeBGZFBatch, this);
+      }
+
+      return !eof;
+    }
+
+    /**
+     * @brief   read up to BGZF_BATCH_BLOCKS compressed blocks and inflate
+     *          them in parallel into 'batch'
+     * @return  count of blocks read, 0 at end of file, -1 if input is malformed
+     */
+    int decodeBGZFBatch ()
+    {
+      std::vector<unsigned char> comp;
+      std::vector<std::size_t> blk_off, out_off (1, 0);
+      std::vector<std::size_t> keep_beg, keep_end; //part of each block to keep when reading indexed chunks
+
+      int nblocks = 0;
+      for (; nblocks < BGZF_BATCH_BLOCKS; nblocks++)
+      {
+        std::size_t trim_beg = 0, trim_end = SIZE_MAX;
+
+        if (indexed)
+        {
+          //advance to the next chunk that still has text to read
+          while (chunk_idx < chunks.size())
+          {
+            if (!in_chunk) { coffset = chunks[chunk_idx].first >> 16; in_chunk = true; }
+            uint64_t ce = chunks[chunk_idx].second;
+            if (coffset < (ce >> 16) || (coffset == (ce >> 16) && (ce & 0xffff) > 0)) break;
+            chunk_idx++; in_chunk = false;
+          }
+          if (chunk_idx == chunks.size()) break;
+
+          uint64_t cb = chunks[chunk_idx].first, ce = chunks[chunk_idx].second;
+          if (coffset == (cb >> 16)) trim_beg = cb & 0xffff;
+          if (coffset == (ce >> 16)) trim_end = ce & 0xffff;
+          if (fseeko(fp, coffset, SEEK_SET) != 0) return -1;
+        }
+
+        unsigned char h[18];
+        std::size_t n = std::fread(h, 1, 18, fp);
+        if (n == 0 && !indexed) break;
+        if (n != 18 || h[0] != 0x1f || h[1] != 0x8b || h[3] != 4 || h[12] != 'B' || h[13] != 'C') return -1;
+
+        std::size_t bsize = (h[16] | (h[17] << 8)) + 1; //total block size
+        if (bsize < 26) return -1;
+
+        std::size_t off = comp.size();
+        comp.resize(off + bsize);
+        std::memcpy(&comp[off], h, 18);
+        if (std::fread(&comp[off + 18], 1, bsize - 18, fp) != bsize - 18) return -1;
+
+        const unsigned char *t = &comp[off + bsize - 4];
+        uint32_t isize = t[0] | (t[1] << 8) | (t[2] << 16) | ((uint32_t) t[3] << 24);
+
+        blk_off.push_back(off);
+        out_off.push_back(out_off.back() + isize);
+        keep_beg.push_back(std::min<std::size_t>(trim_beg, isize));
+        keep_end.push_back(std::min<std::size_t>(trim_end, isize));
+        if (indexed) coffset += bsize;
+      }
+
+      batch.resize(out_off.back());
+      if (nblocks == 0) return 0;
+
+      std::atomic<bool> ok (true);
+      int nthreads = std::min(threads, nblocks);
+
+      auto worker = [&](int tid)
+      {
+        for (int b = tid; b < nblocks; b += nthreads)
+          if (!inflateBGZFBlock(&comp[blk_off[b]], batch.data() + out_off[b], out_off[b+1] - out_off[b]))
+            ok = false;
+      };
+
+      std::vector<std::thread> team;
+      for (int tid = 1; tid < nthreads; tid++) team.emplace_back(worker, tid);
+      worker(0);
+      for (auto &th : team) th.join();
+
+      if (indexed)
+      {
+        //drop text outside of the chunks, blocks are compacted in order
+        std::size_t len = 0;
+        for (int b = 0; b < nblocks; b++)
+        {
+          if (keep_end[b] > keep_beg[b])
+            std::memmove(batch.data() + len, batch.data() + out_off[b] + keep_beg[b], keep_end[b] - keep_beg[b]);
+          len += (keep_end[b] > keep_beg[b]) ? keep_end[b] - keep_beg[b] : 0;
+        }
+        batch.resize(len);
+      }
+
+      return ok ? nblocks : -1;
+    }
+
+    /**
+     * @brief   decompress a tabix or CSI index file (both are BGZF compressed)
+     */
+    static bool loadIndex (const std::string &index_file, std::vector<unsigned char> &idx)
+    {
+      gzFile f = gzopen(index_file.c_str(), "rb");
+      if (f == NULL) return false;
+
+      unsigned char tmp[1 << 16];
+      int n;
+      while ((n = gzread(f, tmp, sizeof(tmp))) > 0)
+        idx.insert(idx.end(), tmp, tmp + n);
+      gzclose(f);
+
+      return n == 0 && idx.size() >= 4;
+    }
+
+    /**
+     * @brief   collect chunks of virtual offsets overlapping the region,
+     *          following the binning scheme of the SAM/tabix/CSI specifications
+     */
+    static bool queryIndex (const std::vector<unsigned char> &idx, bool csi, const VCFRegion &region, std::vector<std::pair<uint64_t,uint64_t>> &list)
+    {
+      std::size_t p = 0;
+      bool ok = true;
+      auto u32 = [&]() -> uint32_t
+      {
+        if (p + 4 > idx.size()) { ok = false; p = idx.size(); return 0; }
+        uint32_t v = idx[p] | (idx[p+1] << 8) | (idx[p+2] << 16) | ((uint32_t) idx[p+3] << 24);
+        p += 4; return v;
+      };
+      auto u64 = [&]() -> uint64_t { uint64_t lo = u32(); return lo | ((uint64_t) u32() << 32); };
+      auto names = [&](std::size_t l_nm) -> std::vector<std::string>
+      {
+        std::vector<std::string> v;
+        if (p + l_nm > idx.size()) { ok = false; return v; }
+        const char *b = reinterpret_cast<const char*>(&idx[p]), *e = b + l_nm;
+        while (b < e)
+        {
+          const char *t = std::find(b, e, '\0');
+          v.push_back(std::string(b, t));
+          b = t + 1;
+        }
+        p += l_nm;
+        return v;
+      };
+
+      int min_shift = 14, depth = 5;
+      std::vector<std::string> seqnames;
+      int32_t n_ref;
+
+      if (csi)
+      {
+        if (std::memcmp(&idx[0], "CSI\1", 4) != 0) return false;
+        p = 4;
+        min_shift = u32(); depth = u32();
+        std::size_t l_aux = u32(), aux_end = p + l_aux;
+        if (l_aux < 28) return false; //sequence names are required
+        p += 24; //format, col_seq, col_beg, col_end, meta, skip
+        seqnames = names(u32());
+        p = aux_end;
+        n_ref = u32();
+      }
+      else
+      {
+        if (std::memcmp(&idx[0], "TBI\1", 4) != 0) return false;
+        p = 4;
+        n_ref = u32();
+        p += 24; //format, col_seq, col_beg, col_end, meta, skip
+        seqnames = names(u32());
+      }
+      if (!ok || n_ref < 0 || (std::size_t) n_ref != seqnames.size() || min_shift <= 0 || depth < 0) return false;
+
+      int tid = std::find(seqnames.begin(), seqnames.end(), region.chr) - seqnames.begin();
+
+      //0-based, half-open query interval
+      int64_t max_len = (int64_t) 1 << (min_shift + depth * 3);
+      int64_t beg = std::max(0, region.beg - 1), end = std::min<int64_t>(region.end, max_len);
+      uint32_t pseudo_bin = ((1u << ((depth + 1) * 3)) - 1) / 7 + 1;
+
+      //bins overlapping [beg, end)
+      std::vector<uint32_t> qbins;
+      for (int l = 0, s = min_shift + depth * 3, t = 0; l <= depth; s -= 3, t += 1 << (l * 3), l++)
+        for (int64_t b = t + (beg >> s); b <= t + ((end - 1) >> s); b++)
+          qbins.push_back(b);
+      std::sort(qbins.begin(), qbins.end());
+
+      for (int32_t r = 0; r < n_ref && ok; r++)
+      {
+        std::vector<std::pair<uint64_t,uint64_t>> cand;
+        std::vector<std::pair<uint32_t,uint64_t>> bin_loff;
+
+        int32_t n_bin = u32();
+        for (int32_t b = 0; b < n_bin && ok; b++)
+        {
+          uint32_t bin = u32();
+          uint64_t loff = csi ? u64() : 0;
+          int32_t n_chunk = u32();
+          bool want = r == tid && bin < pseudo_bin && std::binary_search(qbins.begin(), qbins.end(), bin);
+          if (r == tid && csi) bin_loff.push_back(std::make_pair(bin, loff));
+          for (int32_t c = 0; c < n_chunk && ok; c++)
+          {
+            uint64_t cb = u64(), ce = u64();
+            if (want) cand.push_back(std::make_pair(cb, ce));
+          }
+        }
+
+        //smallest virtual offset a record overlapping 'beg' can start at
+        uint64_t min_off = 0;
+        if (csi)
+        {
+          std::sort(bin_loff.begin(), bin_loff.end());
+          uint32_t bin = ((1u << (depth * 3)) - 1) / 7 + (beg >> min_shift);
+          while (true)
+          {
+            auto it = std::lower_bound(bin_loff.begin(), bin_loff.end(), std::make_pair(bin, (uint64_t) 0));
+            if (it != bin_loff.end() && it->first == bin) { min_off = it->second; break; }
+            if (bin == 0) break;
+            bin = (bin - 1) >> 3;
+          }
+        }
+        else
+        {
+          int32_t n_intv = u32();
+          for (int32_t i = 0; i < n_intv && ok; i++)
+          {
+            uint64_t ioff = u64();
+            if (r == tid && (i == (beg >> 14) || (i == n_intv - 1 && (beg >> 14) >= n_intv))) min_off = ioff;
+          }
+        }
+
+        if (r != tid) continue;
+
+        //drop chunks ending before min_off, then merge overlapping ones
+        std::sort(cand.begin(), cand.end());
+        for (auto &c : cand)
+        {
+          if (c.second <= min_off) continue;
+          c.first = std::max(c.first, min_off);
+          if (!list.empty() && c.first <= list.back().second)
+            list.back().second = std::max(list.back().second, c.second);
+          else
+            list.push_back(c);
+        }
+      }
+
+      return ok;
+    }
+
+    /**
+     * @brief   inflate a single BGZF block into out[0..isize), checking its CRC
+     */
+    static bool inflateBGZFBlock (const unsigned char *block, char *out, std::size_t isize)
+    {
+      std::size_t xlen = block[10] | (block[11] << 8);
+      std::size_t bsize = (block[16] | (block[17] << 8)) + 1;
+      std::size_t hlen = 12 + xlen;
+      if (bsize < hlen + 8) return false;
+
+      z_stream zs;
+      std::memset(&zs, 0, sizeof(zs));
+      if (inflateInit2(&zs, -15) != Z_OK) return false;
+
+      zs.next_in = const_cast<unsigned char*>(block + hlen);
+      zs.avail_in = bsize - hlen - 8;
+      zs.next_out = reinterpret_cast<unsigned char*>(out);
+      zs.avail_out = isize;
+
+      int ret = inflate(&zs, Z_FINISH);
+      inflateEnd(&zs);
+      if (ret != Z_STREAM_END || zs.total_out != isize) return false;
+
+      const unsigned char *t = block + bsize - 8;
+      uint32_t crc = t[0] | (t[1] << 8) | (t[2] << 16) | ((uint32_t) t[3] << 24);
+      return crc32(0L, reinterpret_cast<unsigned char*>(out), isize) == crc;
+    }
+};
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef VF_WINDOW_HPP
+#define VF_WINDOW_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cassert>
+
+/********* Window constraints over variant positions ******/
+
+/*
+ * A window is a range [beg, end] of indices into pos_u. The penalty of the
+ * dropped positions within each window must stay within delta. Penalties are
+ * non-negative, so a window contained in another one never adds a constraint.
+ * Windows keeps the maximal ones only; sorted by end, their beg is strictly
+ * increasing too, which allows two-pointer scans over them.
+ */
+
+struct Windows
+{
+  std::vector<int> beg, end;
+
+  std::size_t size () const { return beg.size(); }
+};
+
+/**
+ * @brief   window ranges of one alpha, right windows are only filled when
+ *          windows starting at variant positions are constrained too
+ */
+struct WindowRanges
+{
+  std::vector<int> start;   //first variant position of the window ending at each variant position
+  Windows right;
+};
+
+/**
+ * @brief   index of the first variant position of the window ending at each
+ *          variant position i, i.e., of the first one after reach[i]. The
+ *          index follows reach with a forward pointer, and gallops from the
+ *          previous index where reach steps back after a deletion edge or
+ *          jumps far ahead. Linear time while reach is non-decreasing.
+ */
+void leftWindowStarts (std::vector<int> &start, const std::vector<int> &reach, const std::vector<int> &pos_u)
+{
+  assert (reach.size() == pos_u.size());
+  int n = pos_u.size();
+  start.resize(n);
+
+  int b = 0;   //pos_u[b-1] <= reach[i] < pos_u[b] on exit of each step
+  for (int i = 0; i < n; i++)
+  {
+    int r = reach[i], lo, hi;
+    if (b < n && pos_u[b] <= r)
+    {
+      //forward: bracket the answer within (lo, hi]
+      int step = 1; lo = b;
+      while (lo + step < n && pos_u[lo + step] <= r) { lo += step; step <<= 1; }
+      hi = std::min(lo + step, n);
+      lo++;
+    }
+    else if (b > 0 && pos_u[b-1] > r)
+    {
+      //backward: bracket the answer within [lo, hi)
+      int step = 1; hi = b - 1;
+      while (hi - step >= 0 && pos_u[hi - step] > r) { hi -= step; step <<= 1; }
+      lo = std::max(hi - step + 1, 0);
+    }
+    else { start[i] = b; continue; }
+
+    b = std::upper_bound (pos_u.begin() + lo, pos_u.begin() + hi, r) - pos_u.begin();
+    start[i] = b;
+  }
+}
+
+/**
+ * @brief   maximal windows ending at each variant position i and starting
+ *          at start[i], see leftWindowStarts
+ */
+void leftWindows (Windows &w, const std::vector<int> &start)
+{
+  int n = start.size();
+
+  //window i is contained in window k > i iff start[k] <= start[i],
+  //scanning backwards keeps the maximal ones in decreasing order
+  w.beg.clear(); w.end.clear();
+  int suffix_min = INT_MAX;
+  for (int i = n-1; i >= 0; i--)
+  {
+    if (start[i] >= suffix_min) continue;
+    suffix_min = start[i];
+    if (start[i] > i) continue; //empty window
+    w.beg.push_back(start[i]); w.end.push_back(i);
+  }
+  std::reverse (w.beg.begin(), w.beg.end());
+  std::reverse (w.end.begin(), w.end.end());
+}
+
+/**
+ * @brief   maximal windows starting at each variant position j and ending at
+ *          its right-most reachable vertex reach[j]
+ */
+void rightWindows (Windows &w, const std::vector<int> &reach, const std::vector<int> &pos_u)
+{
+  assert (reach.size() == pos_u.size());
+  int n = pos_u.size();
+
+  //window j is contained in window k < j iff reach[k] >= reach[j]
+  w.beg.clear(); w.end.clear();
+  int prefix_max = INT_MIN, e = -1;
+  for (int j = 0; j < n; j++)
+  {
+    if (reach[j] <= prefix_max) continue;
+    prefix_max = reach[j];
+    while (e+1 < n && pos_u[e+1] <= reach[j]) e++;
+    if (w.size() > 0 && w.end.back() == e) continue;
+    w.beg.push_back(j); w.end.push_back(e);
+  }
+}
+
+/**
+ * @brief   maximal windows of the union of a and b
+ */
+void mergeWindows (Windows &w, const Windows &a, const Windows &b)
+{
+  w.beg.clear(); w.end.clear();
+  std::size_t i = 0, j = 0;
+  while (i < a.size() || j < b.size())
+  {
+    //by beg, then longer first
+    bool take_a = j == b.size() || (i < a.size() && (a.beg[i] < b.beg[j] || (a.beg[i] == b.beg[j] && a.end[i] >= b.end[j])));
+    int beg = take_a ? a.beg[i] : b.beg[j];
+    int end = take_a ? a.end[i++] : b.end[j++];
+    if (w.size() > 0 && end <= w.end.back()) continue; //contained in the last one
+    w.beg.push_back(beg); w.end.push_back(end);
+  }
+}
+
+/**
+ * @brief   maximal windows of the left windows starting at start together
+ *          with right
+ */
+void constraintWindows (Windows &w, const std::vector<int> &start, const Windows &right)
+{
+  Windows left;
+  leftWindows (left, start);
+  mergeWindows (w, left, right);
+}
+
+/**
+ * @brief   check that the penalty of dropped positions (R[i] = false) within
+ *          each window stays within delta, in a single pass
+ * @return  count of violated windows
+ */
+std::size_t verifyWindows (const std::vector<bool> &R, const std::vector<int> &penalty, const Windows &w, const int &delta)
+{
+  std::size_t violated = 0;
+  long sum = 0;   //dropped penalty of positions [w.beg[k], i)
+  std::size_t i = 0, b = 0;
+  for (std::size_t k = 0; k < w.size(); k++)
+  {
+    for (; b < (std::size_t) w.beg[k]; b++) if (b < i && !R[b]) sum -= penalty[b];
+    if (i < b) i = b;
+    for (; i <= (std::size_t) w.end[k]; i++) if (!R[i]) sum += penalty[i];
+    if (sum > delta) violated++;
+  }
+  return violated;
+}
+
+/**
+ * @brief   verify the result of variant selection against windows and
+ *          report those exceeding delta
+ */
+void printWindowCheck (const std::vector<bool> &R, const std::vector<int> &penalty, const Windows &w, const int &delta)
+{
+  std::size_t violated = verifyWindows (R, penalty, w, delta);
+  if (violated == 0)
+    std::cout << "INFO, VF::printWindowCheck, all " << w.size() << " maximal windows satisfy delta" << "\n";
+  else
+    std::cerr << "WARNING, VF::printWindowCheck, " << violated << " of " << w.size() << " maximal windows exceed delta" << std::endl;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include "../src/reach.hpp"
+#include "../src/penalty.hpp"
+#include "../src/window.hpp"
+#include "../src/blocks.hpp"
+
+/*
+ * Greedy selection with --symmetric must satisfy every maximal window.
+ * Synthetic SNPs and indels with deletions of 2-60 bp make left-most reach
+ * decrease, so later left windows begin before earlier ones.
+ */
+
+int main ()
+{
+  std::mt19937 rng (7);
+  std::vector<int> indelpos, indellen, snppos, snpcount, pos_u;
+  int p = 100;
+  for (int i = 0; i < 20000; i++)
+  {
+    p += std::uniform_int_distribution<int>(1, 12)(rng);
+    double r = std::uniform_real_distribution<double>(0, 1)(rng);
+    if (r < 0.6) { snppos.push_back(p); snpcount.push_back(1); }
+    else if (r < 0.85) { indelpos.push_back(p); indellen.push_back(-std::uniform_int_distribution<int>(2, 60)(rng)); }
+    else { indelpos.push_back(p); indellen.push_back(std::uniform_int_distribution<int>(1, 10)(rng)); }
+    pos_u.push_back(p);
+  }
+  int n = pos_u.size();
+
+  std::vector<int> penalty (n), c (n, 0), c_snp (n, 0);
+  calculatePenalty (penalty, c, c_snp, pos_u, indelpos, indellen, snppos, snpcount);
+
+  int failed = 0;
+  for (int alpha: {50, 100, 200, 500})
+  {
+    std::vector<int> reach (n), reach_right (n), start;
+    calculateLeftMostReachable (reach, pos_u, indelpos, indellen, alpha);
+    calculateRightMostReachable (reach_right, pos_u, indelpos, indellen, alpha);
+    leftWindowStarts (start, reach, pos_u);
+    Windows right, windows;
+    rightWindows (right, reach_right, pos_u);
+    constraintWindows (windows, start, right);
+
+    for (int delta: {1, 5, 20, 100})
+    {
+      std::vector<bool> R (n, 0), R_blocks (n, 0);
+      greedySelect (R, start, right, penalty, delta);
+      greedySelectBlocks (R_blocks, start, right, penalty, delta, 4);
+
+      std::size_t violated = verifyWindows (R, penalty, windows, delta);
+      if (violated > 0 || R != R_blocks)
+      {
+        std::cerr << "ERROR, window_check, alpha = " << alpha << ", delta = " << delta << ", " << violated << " of " << windows.size() << " maximal windows exceed delta"
+                  << (R != R_blocks ? ", blocks differ" : "") << std::endl;
+        failed++;
+      }
+    }
+  }
+
+  if (failed == 0) std::cout << "INFO, window_check, all symmetric greedy selections satisfy delta" << "\n";
+  return failed == 0 ? 0 : 1;
+}